@@ -89,6 +89,8 @@ function(add_catch TARGET)
   target_link_libraries(${TARGET}
     contrib_catch_main)
 
+  add_test(NAME ${TARGET} COMMAND ${TARGET})
+
   if (TEST_SOLUTION)
     add_custom_target(
       run_${TARGET}
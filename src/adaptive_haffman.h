@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "bits_stream.h"
+#include "byte_sink.h"
+
+/**
+ * @brief Haffman tree of bytes updated after every coded byte by FGK algorithm, so encoder and decoder build the
+ * same codes without a table
+ *
+ * Bytes that are not seen yet are coded by the code of NYT (not yet transmitted) leaf followed by 8 bits of the byte.
+ * Nodes are stored by their numbers: weights never decrease with the number and the root has the largest one.
+ */
+class AdaptiveHaffmanTree {
+public:
+    static constexpr size_t ALPHABET_SIZE = 256;
+    // a leaf of a tree with ALPHABET_SIZE + 1 leaves, followed by a raw byte
+    static constexpr size_t MAX_CODE_SIZE = ALPHABET_SIZE + 8;
+
+    AdaptiveHaffmanTree() {
+        leaves_.fill(NO_NODE);
+        nodes_[ROOT] = {0, NO_NODE, NO_NODE, NO_NODE, NYT_SYMBOL};
+    }
+
+    template <typename StreamT>
+    void Encode(uint8_t byte, BitsOStream<StreamT> &stream) {
+        uint16_t leaf = leaves_[byte];
+        WritePath(leaf == NO_NODE ? nyt_ : leaf, stream);
+        if (leaf == NO_NODE) {
+            stream.Write(byte, 8);
+        }
+        Update(byte);
+    }
+
+    template <typename StreamT>
+    uint8_t Decode(BitsIStream<StreamT> &stream) {
+        uint16_t node = ROOT;
+        while (nodes_[node].left != NO_NODE) {
+            node = stream.Read(1) ? nodes_[node].right : nodes_[node].left;
+        }
+        uint8_t byte = node == nyt_ ? static_cast<uint8_t>(stream.Read(8)) : static_cast<uint8_t>(nodes_[node].symbol);
+        Update(byte);
+        return byte;
+    }
+
+private:
+    static constexpr uint16_t NO_NODE = UINT16_MAX;
+    static constexpr uint16_t NYT_SYMBOL = ALPHABET_SIZE;
+    static constexpr uint16_t ROOT = 2 * ALPHABET_SIZE;
+
+    struct Node {
+        size_t weight;
+        uint16_t parent;
+        uint16_t left;
+        uint16_t right;
+        uint16_t symbol;
+    };
+
+    /**
+     * @brief writes path from the root to `node`, 0 for left child and 1 for right one
+     */
+    template <typename StreamT>
+    void WritePath(uint16_t node, BitsOStream<StreamT> &stream) const {
+        std::array<uint8_t, MAX_CODE_SIZE> path;
+        size_t length = 0;
+        for (; node != ROOT; node = nodes_[node].parent) {
+            path[length++] = nodes_[nodes_[node].parent].right == node;
+        }
+        while (length > 0) {
+            unsigned part = static_cast<unsigned>(std::min<size_t>(length, 32));
+            uint64_t value = 0;
+            for (unsigned i = 0; i < part; ++i) {
+                value = (value << 1) | path[--length];
+            }
+            stream.Write(value, part);
+        }
+    }
+
+    /**
+     * @brief exchanges subtrees at numbers `first` and `second`, neither is an ancestor of another
+     */
+    void SwapNodes(uint16_t first, uint16_t second) {
+        std::swap(nodes_[first].weight, nodes_[second].weight);
+        std::swap(nodes_[first].left, nodes_[second].left);
+        std::swap(nodes_[first].right, nodes_[second].right);
+        std::swap(nodes_[first].symbol, nodes_[second].symbol);
+        for (uint16_t node : {first, second}) {
+            if (nodes_[node].left != NO_NODE) {
+                nodes_[nodes_[node].left].parent = node;
+                nodes_[nodes_[node].right].parent = node;
+            } else if (nodes_[node].symbol == NYT_SYMBOL) {
+                nyt_ = node;
+            } else {
+                leaves_[nodes_[node].symbol] = node;
+            }
+        }
+    }
+
+    void Update(uint8_t byte) {
+        uint16_t node = leaves_[byte];
+        if (node == NO_NODE) {
+            // NYT becomes parent of the new NYT and the new leaf
+            uint16_t parent = nyt_;
+            nyt_ = parent - 2;
+            node = parent - 1;
+            nodes_[parent].left = nyt_;
+            nodes_[parent].right = node;
+            nodes_[parent].symbol = NO_NODE;
+            nodes_[nyt_] = {0, parent, NO_NODE, NO_NODE, NYT_SYMBOL};
+            nodes_[node] = {0, parent, NO_NODE, NO_NODE, byte};
+            leaves_[byte] = node;
+        }
+        while (node != NO_NODE) {
+            uint16_t leader = node;
+            while (leader + 1 <= ROOT && nodes_[leader + 1].weight == nodes_[node].weight) {
+                ++leader;
+            }
+            if (leader != node && leader != nodes_[node].parent) {
+                SwapNodes(node, leader);
+                node = leader;
+            }
+            ++nodes_[node].weight;
+            node = nodes_[node].parent;
+        }
+    }
+
+    std::array<Node, ROOT + 1> nodes_;
+    std::array<uint16_t, ALPHABET_SIZE> leaves_;
+    uint16_t nyt_ = ROOT;
+};
+
+/**
+ * @return payload of an adaptive Haffman block
+ */
+inline std::vector<char> EncodeAdaptiveBlock(std::span<const char> data) {
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    AdaptiveHaffmanTree tree;
+    for (char c : data) {
+        tree.Encode(static_cast<uint8_t>(c), stream);
+    }
+    stream.Flush();
+    return std::move(sink.Bytes());
+}
+
+/**
+ * @brief decodes `size` bytes of an adaptive Haffman block to `out`
+ */
+template <typename StreamT>
+void DecodeAdaptiveBlock(BitsIStream<StreamT> &stream, char *out, size_t size) {
+    AdaptiveHaffmanTree tree;
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = static_cast<char>(tree.Decode(stream));
+    }
+}
@@ -1,30 +1,41 @@
+#include <algorithm>
 #include <compare>
 #include <cstddef>
 #include <ios>
 #include <iostream>
 #include <istream>
-#include <map>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <stdexcept>
 #include <iterator>
 #include <array>
 #include <limits>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <deque>
 #include <vector>
 #include <memory>
 #include <utility>
 
+#include "adaptive_haffman.h"
+#include "archive.h"
 #include "bits_stream.h"
-#include "priority_queue.h"
-#include "trie.h"
+#include "blocks.h"
+#include "byte_sink.h"
+#include "byte_source.h"
+#include "codes_io.h"
+#include "context_tables.h"
+#include "haffman_codes.h"
+#include "histogram.h"
 #include "nine_bits.h"
 #include "symbols_counter.h"
+#include "thread_pool.h"
 #include "bits.h"
 #include "constants.h"
 
-using SortedHaffmanCodes = const std::vector<std::pair<NineBits, Bits>>;
-using HaffmanCodes = std::map<NineBits, Bits>;
+static const size_t CHUNK_SIZE = 1 << 20;
 
 template <typename It>
 static void CountSymbols(It first, It last, SymbolsCounter &counter) {
@@ -34,124 +45,539 @@ static void CountSymbols(It first, It last, SymbolsCounter &counter) {
 }
 
 /**
- * @brief build canonical Haffman codes
+ * @brief throws if a byte has no code, which happens when the file changes between counting and encoding
  */
-static SortedHaffmanCodes BuildCodes(const SymbolsCounter &counter) {
-    using HaffmanTrieNode = TrieNode<NineBits, 2>;
+template <typename StreamT>
+static void ArchiveIt(const char *first, const char *last, const EncodeTable &codes,
+                      BitsOStream<StreamT> &archive_stream) {
+    for (; first != last; ++first) {
+        archive_stream << codes.At(CharToNineBits(*first));
+    }
+}
 
-    struct PQValue {
-        std::unique_ptr<HaffmanTrieNode> node;
-        size_t count;
-        auto operator<=>(const PQValue &other) const {
-            if (count == other.count) {
-                return node->Value() <=> other.node->Value();
-            } else {
-                return count <=> other.count;
-            }
+/**
+ * @return number of bytes read, less than `size` only at the end of stream
+ */
+static size_t ReadFull(std::istream &stream, char *first, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        auto read = stream.rdbuf()->sgetn(first + total, static_cast<std::streamsize>(size - total));
+        if (read <= 0) {
+            break;
         }
-    };
+        total += read;
+    }
+    return total;
+}
 
-    PriorityQueue<PQValue, std::greater<PQValue>> chars;
-    for (size_t i = 0; i < counter.size(); ++i) {
-        auto c = static_cast<NineBits>(i);
-        if (counter[i] == 0) {
-            continue;
+/**
+ * @brief reads `stream` up to its end into `buffer`, which grows if it is not large enough
+ *
+ * @return number of bytes read
+ */
+static size_t ReadAll(std::istream &stream, std::vector<char> &buffer) {
+    size_t size = 0;
+    while (true) {
+        size += ReadFull(stream, buffer.data() + size, buffer.size() - size);
+        if (size < buffer.size()) {
+            return size;
         }
-        auto node = std::make_unique<HaffmanTrieNode>(true, c);
-        chars.Push({std::move(node), counter[i]});
+        buffer.resize(std::max(CHUNK_SIZE, 2 * buffer.size()));
     }
-    if (chars.Size() == 0) {
-        return {};
-    }
-    while (chars.Size() >= 2) {
-        auto pq_v0 = chars.TopPop();
-        auto pq_v1 = chars.TopPop();
-        NineBits min_c = std::min(pq_v0.node->Value(), pq_v1.node->Value());
-        auto new_node = std::make_unique<HaffmanTrieNode>(false, min_c);
-        new_node->SetChildren(0, std::move(pq_v0.node));
-        new_node->SetChildren(1, std::move(pq_v1.node));
-        chars.Push({std::move(new_node), pq_v0.count + pq_v1.count});
+}
+
+/**
+ * @brief reads `stream` into `buffer` by pieces of buffer's size and calls `on_chunk(first, last)` for each
+ */
+template <typename F>
+static void ForEachChunk(std::istream &stream, std::vector<char> &buffer, F on_chunk) {
+    while (size_t read = ReadFull(stream, buffer.data(), buffer.size())) {
+        on_chunk(buffer.data(), buffer.data() + read);
     }
+}
 
-    std::vector<std::pair<size_t, NineBits>> codes_sizes;
-    chars.TopPop().node->WalkTrie([&codes_sizes](auto way, NineBits symbol) {
-        codes_sizes.push_back({way.size(), symbol});
+/**
+ * @param for_each_chunk is called twice with `on_chunk(first, last)`, which must be invoked for every chunk of content
+ * @param previous_table codes of the previous file if they may be reused, replaced by codes of this one
+ * @return size of content
+ */
+template <typename StreamT, typename ForEachChunkF>
+static size_t ArchiveContent(const std::string &filename, ForEachChunkF for_each_chunk,
+                           BitsOStream<StreamT> &archive_stream, bool is_last_file, const ArchiveOptions &options,
+                           std::shared_ptr<const BlockTable> &previous_table, ThreadPool *pool) {
+    SymbolsCounter counter;
+    size_t content_size = 0;
+    for_each_chunk([&counter, &content_size, pool](const char *first, const char *last) {
+        content_size += last - first;
+        if (pool != nullptr) {
+            ParallelCountBytes(first, last, counter, *pool);
+        } else {
+            CountBytes(first, last, counter);
+        }
     });
-    std::sort(codes_sizes.begin(), codes_sizes.end());
+    CountSymbols(filename.begin(), filename.end(), counter);
+    ++counter[FILENAME_END];
+    ++counter[ONE_MORE_FILE];
+    ++counter[ARCHIVE_END];
 
-    std::vector<std::pair<NineBits, Bits>> codes;
-    codes.reserve(codes_sizes.size());
-    auto code = Bits() << codes_sizes[0].first;
-    codes.emplace_back(codes_sizes[0].second, code);
-    for (size_t i = 1; i < codes_sizes.size(); ++i) {
-        code = (++code) << static_cast<size_t>(codes_sizes[i].first - codes_sizes[i - 1].first);
-        codes.emplace_back(codes_sizes[i].second, code);
+    auto table = std::make_shared<const BlockTable>(counter, options.max_code_length);
+    size_t previous_size = previous_table ? previous_table->EncodedSize(counter) : std::numeric_limits<size_t>::max();
+    // the mark of reused codes takes 9 bits
+    if (previous_size != std::numeric_limits<size_t>::max() &&
+        9 + previous_size < ArchivedCodesSize(table->sorted_codes) + table->EncodedSize(counter)) {
+        archive_stream << static_cast<NineBits>(PREVIOUS_CODES_MARK);
+        table = previous_table;
+    } else {
+        ArchiveCodes(table->sorted_codes, archive_stream);
+        previous_table = table;
     }
-    return codes;
-}
+    const EncodeTable &codes = table->codes;
 
-template <typename It, typename StreamT>
-static void ArchiveIt(It first, It last, const HaffmanCodes &codes, BitsOStream<StreamT> &archive_stream) {
-    for (; first != last; ++first) {
-        archive_stream << codes.at(CharToNineBits(*first));
+    ArchiveIt(filename.data(), filename.data() + filename.size(), codes, archive_stream);
+    archive_stream << codes[FILENAME_END];
+    for_each_chunk([&](const char *first, const char *last) { ArchiveIt(first, last, codes, archive_stream); });
+    if (is_last_file) {
+        archive_stream << codes[ARCHIVE_END];
+    } else {
+        archive_stream << codes[ONE_MORE_FILE];
     }
+    return content_size;
 }
 
-template <typename StreamT>
-static void ArchiveCodes(const SortedHaffmanCodes &sorted_codes, BitsOStream<StreamT> &archive_stream) {
-    archive_stream << static_cast<NineBits>(sorted_codes.size());
-    std::vector<size_t> count_with_lengths;
-    for (const auto &[symbol, code] : sorted_codes) {
-        archive_stream << symbol;
-        while (count_with_lengths.size() < code.Size()) {
-            count_with_lengths.push_back(0);
+/**
+ * @brief block of content referencing memory that outlives archiving of the member or owning its bytes
+ */
+struct RawBlock {
+    std::vector<char> storage;
+    std::span<const char> data;
+};
+
+/**
+ * @brief whether content starts with a signature of a compressed format, whose content is hardly compressible
+ */
+static bool HasCompressedSignature(std::span<const char> content) {
+    static const std::array<std::string_view, 9> SIGNATURES = {
+        std::string_view("\x1F\x8B", 2),                  // gzip
+        std::string_view("PK\x03\x04", 4),                // zip, jar, docx
+        std::string_view("\x89PNG", 4),                    // png
+        std::string_view("\xFF\xD8\xFF", 3),              // jpeg
+        std::string_view("\x28\xB5\x2F\xFD", 4),          // zstd
+        std::string_view("\xFD" "7zXZ\x00", 6),            // xz
+        std::string_view("BZh", 3),                        // bzip2
+        std::string_view("7z\xBC\xAF\x27\x1C", 6),        // 7z
+        std::string_view(ARCHIVE_MAGIC.data(), ARCHIVE_MAGIC.size()),
+    };
+    std::string_view start(content.data(), content.size());
+    return std::ranges::any_of(SIGNATURES, [start](std::string_view signature) { return start.starts_with(signature); });
+}
+
+/**
+ * @brief whether no order-0 code makes content with `counter` smaller than `size` bytes
+ */
+static bool IsIncompressible(const SymbolsCounter &counter, size_t size) {
+    return EntropySize(counter) >= 8.0 * static_cast<double>(size);
+}
+
+/**
+ * @brief encodes blocks with Haffman tables, reusing the previous table if the block is not larger with it than with
+ * its own table, or with order-1 tables if they are enabled and make the block smaller than both; blocks are stored
+ * if neither makes them smaller, blocks with single table are interleaved if it is enabled
+ *
+ * @param methods receives methods of the blocks
+ * @return payloads of the blocks, empty for stored ones
+ */
+static std::vector<std::vector<char>> EncodeHaffmanBlocks(const std::vector<RawBlock> &batch,
+                                                          std::shared_ptr<const BlockTable> &previous_table,
+                                                          std::vector<BlockMethod> &methods,
+                                                          const ArchiveOptions &options, ThreadPool *pool) {
+    auto counters = RunAll(pool, batch.size(), [&batch](size_t i) {
+        SymbolsCounter counter;
+        CountBytes(batch[i].data.data(), batch[i].data.data() + batch[i].data.size(), counter);
+        return counter;
+    });
+    auto tables = RunAll(pool, batch.size(), [&](size_t i) -> std::shared_ptr<const BlockTable> {
+        // only order-1 tables may code such blocks shorter than they are
+        if (!options.order1 && IsIncompressible(counters[i], batch[i].data.size())) {
+            return nullptr;
+        }
+        return std::make_shared<const BlockTable>(counters[i], options.max_code_length);
+    });
+    auto context_tables = RunAll(pool, options.order1 ? batch.size() : 0, [&batch, &options](size_t i) {
+        return std::make_unique<const ContextTables>(batch[i].data, options.max_code_length);
+    });
+    for (size_t i = 0; i < batch.size(); ++i) {
+        size_t stored_size = 8 * batch[i].data.size();
+        size_t fresh_size = tables[i] ? ArchivedCodesSize(tables[i]->sorted_codes) + tables[i]->EncodedSize(counters[i])
+                                      : std::numeric_limits<size_t>::max();
+        size_t previous_size =
+            previous_table ? previous_table->EncodedSize(counters[i]) : std::numeric_limits<size_t>::max();
+        size_t single_table_size = std::min(fresh_size, previous_size);
+        if (options.interleaved && single_table_size != std::numeric_limits<size_t>::max()) {
+            single_table_size += INTERLEAVED_OVERHEAD_SIZE;
+        }
+        if (options.order1 && context_tables[i]->ArchivedSize() < std::min(single_table_size, stored_size)) {
+            methods[i] = BlockMethod::HAFFMAN_ORDER1;
+        } else if (stored_size <= single_table_size) {
+            methods[i] = BlockMethod::STORED;
+        } else if (previous_size <= fresh_size) {
+            methods[i] = BlockMethod::HAFFMAN_PREVIOUS_TABLE;
+            tables[i] = previous_table;
+        } else {
+            methods[i] = BlockMethod::HAFFMAN;
+            previous_table = tables[i];
         }
-        ++count_with_lengths.back();
     }
-    for (auto count : count_with_lengths) {
-        archive_stream << static_cast<NineBits>(count);
+    return RunAll(pool, batch.size(), [&](size_t i) {
+        if (methods[i] == BlockMethod::STORED) {
+            return std::vector<char>();
+        }
+        if (methods[i] == BlockMethod::HAFFMAN_ORDER1) {
+            return context_tables[i]->Encode(batch[i].data);
+        }
+        bool write_table = methods[i] == BlockMethod::HAFFMAN;
+        if (options.interleaved) {
+            methods[i] = write_table ? BlockMethod::INTERLEAVED_HAFFMAN : BlockMethod::INTERLEAVED_HAFFMAN_PREVIOUS_TABLE;
+            return EncodeInterleavedBlock(batch[i].data, *tables[i], write_table);
+        }
+        return EncodeBlock(batch[i].data, *tables[i], write_table);
+    });
+}
+
+/**
+ * @brief encodes blocks with adaptive Haffman codes, blocks are stored if the codes don't make them smaller
+ *
+ * @param methods receives methods of the blocks
+ * @return payloads of the blocks, empty for stored ones
+ */
+static std::vector<std::vector<char>> EncodeAdaptiveBlocks(const std::vector<RawBlock> &batch,
+                                                           std::vector<BlockMethod> &methods, ThreadPool *pool) {
+    return RunAll(pool, batch.size(), [&batch, &methods](size_t i) {
+        // adaptive codes are not shorter than the entropy either, and counting is much faster than coding
+        SymbolsCounter counter;
+        CountBytes(batch[i].data.data(), batch[i].data.data() + batch[i].data.size(), counter);
+        if (!IsIncompressible(counter, batch[i].data.size())) {
+            auto payload = EncodeAdaptiveBlock(batch[i].data);
+            if (payload.size() < batch[i].data.size()) {
+                methods[i] = BlockMethod::ADAPTIVE_HAFFMAN;
+                return payload;
+            }
+        }
+        methods[i] = BlockMethod::STORED;
+        return std::vector<char>();
+    });
+}
+
+/**
+ * @brief writes member of block format, blocks of a batch are encoded in parallel by `pool` if it is not null
+ *
+ * With `options.store_compressed` blocks of a member starting with a signature of a compressed format are coded by
+ * single tables only, so they are stored after counting their bytes unless a table makes them smaller.
+ *
+ * @param next_block returns RawBlock with empty data after the last block
+ * @param previous_table table of the previous block, which may be of the previous member, replaced by the last table
+ * of this member
+ * @return size of content
+ */
+template <typename StreamT, typename NextBlockF>
+static size_t ArchiveBlocks(const std::string &filename, NextBlockF next_block, BitsOStream<StreamT> &archive_stream,
+                          const ArchiveOptions &options, std::shared_ptr<const BlockTable> &previous_table,
+                          ThreadPool *pool) {
+    WriteMemberName(archive_stream, filename);
+    size_t batch_size = pool != nullptr ? 2 * pool->Size() : 1;
+    std::vector<RawBlock> batch;
+    size_t content_size = 0;
+    ArchiveOptions block_options = options;
+    while (true) {
+        batch.clear();
+        while (batch.size() < batch_size) {
+            RawBlock block = next_block();
+            if (block.data.empty()) {
+                break;
+            }
+            batch.push_back(std::move(block));
+        }
+        if (batch.empty()) {
+            break;
+        }
+
+        if (content_size == 0 && options.store_compressed && HasCompressedSignature(batch.front().data)) {
+            // such content is hardly compressible, so only the cheap check of a single table is worth it
+            block_options.adaptive = false;
+            block_options.order1 = false;
+        }
+
+        std::vector<BlockMethod> methods(batch.size(), BlockMethod::STORED);
+        auto payloads = block_options.adaptive
+                            ? EncodeAdaptiveBlocks(batch, methods, pool)
+                            : EncodeHaffmanBlocks(batch, previous_table, methods, block_options, pool);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            // content of stored blocks is copied as is, the stream is aligned to byte
+            std::span<const char> payload = methods[i] == BlockMethod::STORED ? batch[i].data : payloads[i];
+            WriteBlockHeader(archive_stream, {methods[i], static_cast<uint32_t>(batch[i].data.size()),
+                                              static_cast<uint32_t>(payload.size())});
+            archive_stream.WriteBits(payload, 8 * payload.size());
+            content_size += batch[i].data.size();
+        }
     }
+    WriteBlockHeader(archive_stream, {BlockMethod::MEMBER_END, 0, 0});
+    return content_size;
 }
 
+/**
+ * @brief ArchiveBlocks reading `content` once by blocks, so it may be a pipe
+ */
 template <typename StreamT>
-static void ArchiveFile(const std::filesystem::path &file, BitsOStream<StreamT> &archive_stream, bool is_last_file) {
-    SymbolsCounter counter;
+static size_t ArchiveStreamBlocks(std::istream &content, const std::string &filename,
+                                  BitsOStream<StreamT> &archive_stream, const ArchiveOptions &options,
+                                  std::shared_ptr<const BlockTable> &previous_table, ThreadPool *pool) {
+    return ArchiveBlocks(
+        filename,
+        [&content, &options] {
+            RawBlock block;
+            block.storage.resize(options.block_size);
+            block.storage.resize(ReadFull(content, block.storage.data(), block.storage.size()));
+            block.data = block.storage;
+            return block;
+        },
+        archive_stream, options, previous_table, pool);
+}
+
+/**
+ * @brief ArchiveFile for block format, content is read once by blocks
+ */
+template <typename StreamT>
+static size_t ArchiveFileBlocks(const std::filesystem::path &file, BitsOStream<StreamT> &archive_stream,
+                              const ArchiveOptions &options, std::shared_ptr<const BlockTable> &previous_table,
+                              ThreadPool *pool) {
+    std::string filename = file.filename();
+
+    if (options.use_mmap && MMapByteSource::CanMap(file)) {
+        MMapByteSource source(file);
+        auto content = source.Data();
+        return ArchiveBlocks(
+            filename,
+            [&content, &options] {
+                RawBlock block;
+                block.data = content.first(std::min(content.size(), options.block_size));
+                content = content.subspan(block.data.size());
+                return block;
+            },
+            archive_stream, options, previous_table, pool);
+    }
 
     std::ifstream file_stream(file, std::ios::binary);
     file_stream.exceptions(std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
-    CountSymbols(std::istreambuf_iterator(file_stream), {}, counter);
-    file_stream.seekg(0);
+    return ArchiveStreamBlocks(file_stream, filename, archive_stream, options, previous_table, pool);
+}
 
+/**
+ * @param is_last_file is used by Haffman stream format only
+ * @param buffer is reused between files, so its memory is allocated once
+ * @param previous_table the last table of the previous file, reused with `options.reuse_tables` only, replaced by
+ * the last table of this file
+ * @param pool counts symbols of large files or encodes their blocks in parallel if not null
+ * @return size of the file
+ */
+template <typename StreamT>
+static size_t ArchiveFile(const std::filesystem::path &file, BitsOStream<StreamT> &archive_stream, bool is_last_file,
+                        const ArchiveOptions &options, std::vector<char> &buffer,
+                        std::shared_ptr<const BlockTable> &previous_table, ThreadPool *pool) {
+    if (!options.reuse_tables) {
+        previous_table.reset();
+    }
+    if (options.format == ArchiveFormat::BLOCKS) {
+        return ArchiveFileBlocks(file, archive_stream, options, previous_table, pool);
+    }
     std::string filename = file.filename();
-    CountSymbols(filename.begin(), filename.end(), counter);
-    ++counter[FILENAME_END];
-    ++counter[ONE_MORE_FILE];
-    ++counter[ARCHIVE_END];
 
-    SortedHaffmanCodes sorted_codes = BuildCodes(counter);
+    if (options.use_mmap && MMapByteSource::CanMap(file)) {
+        MMapByteSource source(file);
+        auto content = source.Data();
+        return ArchiveContent(
+            filename, [content](auto on_chunk) { on_chunk(content.data(), content.data() + content.size()); },
+            archive_stream, is_last_file, options, previous_table, pool);
+    }
+
+    std::ifstream file_stream(file, std::ios::binary);
+    file_stream.exceptions(std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
+    // files like those of /proc and pipes have no size until they are read
+    auto file_size = std::filesystem::is_regular_file(file) ? std::filesystem::file_size(file) : 0;
+    if (file_size <= options.in_memory_limit) {
+        // one extra byte shows whether the file has grown since its size was taken
+        buffer.resize(file_size + 1);
+        size_t content_size = ReadAll(file_stream, buffer);
+        if (file_size != 0 && content_size != file_size) {
+            throw std::runtime_error("File " + file.string() + " changed while archiving");
+        }
+        return ArchiveContent(
+            filename, [&buffer, content_size](auto on_chunk) { on_chunk(buffer.data(), buffer.data() + content_size); },
+            archive_stream, is_last_file, options, previous_table, pool);
+    } else {
+        buffer.resize(CHUNK_SIZE);
+        return ArchiveContent(
+            filename,
+            [&file_stream, &buffer](auto on_chunk) {
+                file_stream.seekg(0);
+                ForEachChunk(file_stream, buffer, on_chunk);
+            },
+            archive_stream, is_last_file, options, previous_table, pool);
+    }
+}
 
-    ArchiveCodes(sorted_codes, archive_stream);
+/**
+ * @brief archived file not aligned to byte, it occupies first `bits` bits of `bytes`
+ */
+struct EncodedFile {
+    std::vector<char> bytes;
+    size_t bits;
+    size_t original_size;
+};
 
-    HaffmanCodes codes(sorted_codes.begin(), sorted_codes.end());
+static EncodedFile EncodeFile(const std::filesystem::path &file, bool is_last_file, const ArchiveOptions &options) {
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    std::vector<char> buffer;
+    std::shared_ptr<const BlockTable> previous_table;
+    size_t original_size = ArchiveFile(file, stream, is_last_file, options, buffer, previous_table, nullptr);
+    size_t bits = stream.WrittenBits();
+    stream.Flush();
+    return {std::move(sink.Bytes()), bits, original_size};
+}
 
-    ArchiveIt(filename.begin(), filename.end(), codes, archive_stream);
-    archive_stream << codes.at(FILENAME_END);
-    ArchiveIt(std::istreambuf_iterator(file_stream), {}, codes, archive_stream);
-    if (is_last_file) {
-        archive_stream << codes.at(ARCHIVE_END);
-    } else {
-        archive_stream << codes.at(ONE_MORE_FILE);
+/**
+ * @brief whether the file is small enough to be encoded into memory by a worker
+ */
+static bool IsEncodedInMemory(const std::filesystem::path &file, const ArchiveOptions &options) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(file, error);
+    // unreadable files fail in the worker with the usual error
+    if (error) {
+        return true;
     }
+    // blocks of larger files are encoded in parallel instead
+    return size <= (options.format == ArchiveFormat::BLOCKS ? options.block_size : options.in_memory_limit);
 }
 
-void Archive(const std::vector<std::filesystem::path> &files, const std::filesystem::path &archive_name) {
-    std::ofstream file_archive_stream(archive_name);
-    file_archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit | std::ios_base::eofbit);
-    BitsOStream archive_stream(file_archive_stream);
+static void CheckOptions(const ArchiveOptions &options) {
+    bool blocks_only =
+        options.write_index || options.adaptive || options.order1 || options.interleaved || options.store_compressed;
+    if (blocks_only && options.format != ArchiveFormat::BLOCKS) {
+        throw std::invalid_argument("Index, adaptive codes, order-1 tables, interleaving and stored blocks are "
+                                    "supported by block format only");
+    }
+    if (options.adaptive && options.order1) {
+        throw std::invalid_argument("Adaptive codes don't use order-1 tables");
+    }
+    if (options.reuse_tables && options.write_index) {
+        throw std::invalid_argument("Index needs files independent of each other, reused tables make them dependent");
+    }
+}
+
+template <typename StreamT>
+static void FinishArchive(BitsOStream<StreamT> &archive_stream, const ArchiveOptions &options,
+                          const std::vector<IndexEntry> &index) {
+    if (options.format == ArchiveFormat::BLOCKS) {
+        archive_stream.Write(static_cast<uint8_t>(MemberTag::ARCHIVE_END), 8);
+    }
+    if (options.write_index) {
+        WriteIndex(archive_stream, index);
+    }
+    archive_stream.Flush();
+}
+
+void Archive(const std::vector<std::filesystem::path> &files, std::ostream &archive, const ArchiveOptions &options) {
+    CheckOptions(options);
+    BitsOStream archive_stream(archive);
+    if (options.format == ArchiveFormat::BLOCKS) {
+        archive_stream.WriteBits(ARCHIVE_MAGIC, 8 * ARCHIVE_MAGIC.size());
+    }
+
+    std::vector<IndexEntry> index;
+    // members are aligned to byte in block format, which is the only one with index
+    auto add_to_index = [&](size_t i, uint64_t offset, size_t original_size) {
+        if (options.write_index) {
+            index.push_back({files[i].filename(), offset, original_size, archive_stream.WrittenBits() / 8 - offset});
+        }
+    };
+    std::unique_ptr<ThreadPool> pool;
+    if (options.threads > 1) {
+        pool = std::make_unique<ThreadPool>(options.threads);
+    }
+    std::vector<char> buffer;
+    std::shared_ptr<const BlockTable> previous_table;
+    auto archive_in_place = [&](size_t i) {
+        uint64_t offset = archive_stream.WrittenBits() / 8;
+        size_t original_size =
+            ArchiveFile(files[i], archive_stream, i == files.size() - 1, options, buffer, previous_table, pool.get());
+        add_to_index(i, offset, original_size);
+    };
+    // a file reusing tables depends on the previous one, so files are not encoded by workers
+    if (!pool || files.size() == 1 || options.reuse_tables) {
+        for (size_t i = 0; i < files.size(); ++i) {
+            archive_in_place(i);
+        }
+        FinishArchive(archive_stream, options, index);
+        return;
+    }
 
+    // small files are encoded by workers and written in their order, so the archive does not depend on
+    // scheduling; large files are encoded in place, counting symbols with the pool
+    std::deque<std::pair<size_t, std::future<EncodedFile>>> encoded;
+    size_t max_pending = 2 * pool->Size();
+    auto write_first_encoded = [&] {
+        auto file = encoded.front().second.get();
+        uint64_t offset = archive_stream.WrittenBits() / 8;
+        archive_stream.WriteBits(file.bytes, file.bits);
+        add_to_index(encoded.front().first, offset, file.original_size);
+        encoded.pop_front();
+    };
     for (size_t i = 0; i < files.size(); ++i) {
-        ArchiveFile(files[i], archive_stream, i == files.size() - 1);
+        if (!IsEncodedInMemory(files[i], options)) {
+            while (!encoded.empty()) {
+                write_first_encoded();
+            }
+            archive_in_place(i);
+            continue;
+        }
+        if (encoded.size() == max_pending) {
+            write_first_encoded();
+        }
+        bool is_last_file = i == files.size() - 1;
+        encoded.emplace_back(i, pool->Submit([&files, &options, i, is_last_file] {
+            return EncodeFile(files[i], is_last_file, options);
+        }));
     }
+    while (!encoded.empty()) {
+        write_first_encoded();
+    }
+    FinishArchive(archive_stream, options, index);
+}
 
-    archive_stream.Flush();
+void Archive(const std::vector<std::filesystem::path> &files, const std::filesystem::path &archive_name,
+             const ArchiveOptions &options) {
+    std::ofstream file_archive_stream(archive_name);
+    file_archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit | std::ios_base::eofbit);
+    Archive(files, file_archive_stream, options);
+}
+
+void ArchiveStream(std::istream &content, const std::string &filename, std::ostream &archive,
+                   const ArchiveOptions &options) {
+    ArchiveOptions blocks_options = options;
+    blocks_options.format = ArchiveFormat::BLOCKS;
+    CheckOptions(blocks_options);
+    BitsOStream archive_stream(archive);
+    archive_stream.WriteBits(ARCHIVE_MAGIC, 8 * ARCHIVE_MAGIC.size());
+    std::unique_ptr<ThreadPool> pool;
+    if (options.threads > 1) {
+        pool = std::make_unique<ThreadPool>(options.threads);
+    }
+    uint64_t offset = archive_stream.WrittenBits() / 8;
+    std::shared_ptr<const BlockTable> previous_table;
+    size_t original_size =
+        ArchiveStreamBlocks(content, filename, archive_stream, blocks_options, previous_table, pool.get());
+    std::vector<IndexEntry> index;
+    if (options.write_index) {
+        index.push_back({filename, offset, original_size, archive_stream.WrittenBits() / 8 - offset});
+    }
+    FinishArchive(archive_stream, blocks_options, index);
 }
@@ -1,6 +1,100 @@
+#pragma once
+
+#include <cstddef>
 #include <filesystem>
+#include <istream>
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include "bits_stream.h"
+#include "blocks.h"
+#include "haffman_codes.h"
+
+enum class ArchiveFormat {
+    /**
+     * @brief every file is a single Haffman stream, the original format
+     */
+    HAFFMAN_STREAM,
+    /**
+     * @brief files are split into independently coded blocks, see blocks.h
+     */
+    BLOCKS,
+};
+
+struct ArchiveOptions {
+    ArchiveFormat format = ArchiveFormat::HAFFMAN_STREAM;
+
+    /**
+     * @brief size of content blocks of block format, in [1; MAX_BLOCK_SIZE]
+     */
+    size_t block_size = DEFAULT_BLOCK_SIZE;
+
+    /**
+     * @brief code blocks by adaptive Haffman codes, which need no table and a single pass over content, block format
+     * only
+     */
+    bool adaptive = false;
+
+    /**
+     * @brief code blocks by Haffman tables per previous byte where it makes them smaller, block format only
+     */
+    bool order1 = false;
+
+    /**
+     * @brief code blocks with a single table to several interleaved bit streams, which are decoded faster, block
+     * format only
+     */
+    bool interleaved = false;
+
+    /**
+     * @brief code files starting with signatures of compressed formats by single tables only, skipping order-1 and
+     * adaptive codes, block format only; their blocks are stored if the table doesn't make them smaller
+     */
+    bool store_compressed = false;
+
+    /**
+     * @brief code a file by the last table of the previous one where it is smaller so; files depend on previous ones
+     * then, so they are archived one after another and index is not supported
+     */
+    bool reuse_tables = false;
+
+    /**
+     * @brief write index of members after them, block format only
+     */
+    bool write_index = false;
+
+    /**
+     * @brief map input files into memory instead of reading them through streams
+     */
+    bool use_mmap = true;
+    /**
+     * @brief without mmap, files up to this size are read into memory once, larger ones are read twice by chunks
+     */
+    size_t in_memory_limit = 64 << 20;
+
+    /**
+     * @brief number of threads archiving files concurrently and counting symbols of large files; the archive does
+     * not depend on it
+     */
+    size_t threads = 1;
+
+    /**
+     * @brief longer codes are not produced, so decoders can rely on this bound
+     */
+    size_t max_code_length = DEFAULT_MAX_CODE_LENGTH;
+};
+
+void Archive(const std::vector<std::filesystem::path> &files, const std::filesystem::path &archive_name,
+             const ArchiveOptions &options = {});
+
+void Archive(const std::vector<std::filesystem::path> &files, std::ostream &archive, const ArchiveOptions &options = {});
 
-void Archive(const std::vector<std::filesystem::path> &files, const std::filesystem::path &archive_name);
+/**
+ * @brief archives `content` as a single file named `filename` in block format regardless of `options.format`
+ *
+ * Content is read once by blocks, which are written to `archive` as soon as they are encoded, so `content` and
+ * `archive` may be pipes and memory use does not depend on size of content.
+ */
+void ArchiveStream(std::istream &content, const std::string &filename, std::ostream &archive,
+                   const ArchiveOptions &options = {});
@@ -1,43 +1,162 @@
+#include <algorithm>
 #include <cstring>
 #include <exception>
 #include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <stdexcept>
+#include <string>
+#include <iostream>
+#include <vector>
+
 #include "archive.h"
+#include "args_parser.h"
 #include "unarchive.h"
 
-class BadArgumentsError : public std::runtime_error {
-    using std::runtime_error::runtime_error;
-};
-
 void PrintHelp() {
     static const std::string HELP_STRING =
         "Usage: \n"
-        "Archive:  archiver -c output_file file1 [file2 [file3 [...]]] \n"
-        "Unarchive:  archiver -d path \n";
+        "Archive:  archiver -c [options] output_file file1 [file2 [file3 [...]]] \n"
+        "  file - is standard input, archived alone in block format as it arrives; output_file - is standard output \n"
+        "Unarchive:  archiver -d [options] path \n"
+        "List files:  archiver -l [options] path \n"
+        "Common options: \n"
+        "  --no-mmap                read input through streams instead of mapping it into memory \n"
+        "  -j THREADS               number of threads to use \n"
+        "Archive options: \n"
+        "  --blocks                 write block format, whose blocks are coded independently \n"
+        "  --block-size BYTES       size of blocks, 1 MiB by default, implies --blocks \n"
+        "  --adaptive               code blocks by adaptive Haffman codes without tables, implies --blocks \n"
+        "  --order1                 code blocks by tables per previous byte where it is smaller, implies --blocks \n"
+        "  --interleaved            code blocks to 4 interleaved streams decoded faster, implies --blocks \n"
+        "  --store-compressed       code files of compressed formats by plain tables or store them, implies --blocks \n"
+        "  --reuse-tables           code files by the table of the previous file where it is smaller \n"
+        "  --index                  write index of files to find them without decoding, implies --blocks \n"
+        "  --in-memory-limit BYTES  without mmap, read larger files twice by chunks instead of into memory \n"
+        "  --max-code-len BITS      limit length of Haffman codes, 15 by default \n"
+        "  --name NAME              name of file read from standard input, stdin by default \n"
+        "Unarchive options: \n"
+        "  -m FILE [FILE [...]]     extract only these files \n"
+        "  -O, --stdout             write contents of files to standard output instead of files \n";
     std::cout << HELP_STRING;
 }
 
+size_t ParseThreads(const std::string& value) {
+    size_t threads = ArgsParser::ParseSize(value);
+    if (threads == 0) {
+        throw BadArgumentsError("Number of threads must be positive");
+    }
+    return threads;
+}
+
 void ParseArgsAndDo(int argc, char** argv) {
     if (argc < 2) {
         throw BadArgumentsError("Command Not Found");
     }
+    ArgsParser parser;
     if (strcmp(argv[1], "-d") == 0) {
-        if (argc == 3) {
-            std::string archive = argv[2];
-            std::cout << "Unarchive \"" + archive + "\"\n";
-            Unarchive(std::filesystem::path(archive));
+        UnarchiveOptions options;
+        parser.AddFlag("--no-mmap", [&options] { options.use_mmap = false; });
+        parser.AddOption("-j", [&options](const std::string& value) { options.threads = ParseThreads(value); });
+        parser.AddMultiOption("-m", [&options](const std::string& value) { options.members.push_back(value); });
+        bool to_stdout = false;
+        parser.AddFlag("-O", [&to_stdout] { to_stdout = true; });
+        parser.AddFlag("--stdout", [&to_stdout] { to_stdout = true; });
+        auto args = parser.Parse(argc, argv, 2);
+        if (args.size() == 1) {
+            std::string archive = args[0];
+            if (to_stdout) {
+                StreamUnarchiveSink sink(std::cout);
+                Unarchive(std::filesystem::path(archive), sink, options);
+            } else {
+                std::cout << "Unarchive \"" + archive + "\"\n";
+                Unarchive(std::filesystem::path(archive), options);
+            }
         } else {
             throw BadArgumentsError("Unvalid number of arguments");
         }
     } else if (strcmp(argv[1], "-c") == 0) {
-        if (argc >= 4) {
-            std::string archive = argv[2];
-            std::cout << "Archive to \"" + archive + "\"\n";
-            std::vector<std::filesystem::path> files;
-            for (int i = 3; i < argc; ++i) {
-                files.emplace_back(argv[i]);
-            }
-            Archive(files, std::filesystem::path(archive));
+        ArchiveOptions options;
+        parser.AddFlag("--no-mmap", [&options] { options.use_mmap = false; });
+        parser.AddOption("--in-memory-limit",
+                         [&options](const std::string& value) { options.in_memory_limit = ArgsParser::ParseSize(value); });
+        parser.AddOption("-j", [&options](const std::string& value) { options.threads = ParseThreads(value); });
+        parser.AddFlag("--blocks", [&options] { options.format = ArchiveFormat::BLOCKS; });
+        parser.AddFlag("--adaptive", [&options] {
+            options.format = ArchiveFormat::BLOCKS;
+            options.adaptive = true;
+        });
+        parser.AddFlag("--order1", [&options] {
+            options.format = ArchiveFormat::BLOCKS;
+            options.order1 = true;
+        });
+        parser.AddFlag("--interleaved", [&options] {
+            options.format = ArchiveFormat::BLOCKS;
+            options.interleaved = true;
+        });
+        parser.AddFlag("--store-compressed", [&options] {
+            options.format = ArchiveFormat::BLOCKS;
+            options.store_compressed = true;
+        });
+        parser.AddFlag("--reuse-tables", [&options] { options.reuse_tables = true; });
+        parser.AddFlag("--index", [&options] {
+            options.format = ArchiveFormat::BLOCKS;
+            options.write_index = true;
+        });
+        parser.AddOption("--block-size", [&options](const std::string& value) {
+            options.format = ArchiveFormat::BLOCKS;
+            options.block_size = ArgsParser::ParseSize(value);
+            if (options.block_size == 0 || options.block_size > MAX_BLOCK_SIZE) {
+                throw BadArgumentsError("Block size must be in [1; " + std::to_string(MAX_BLOCK_SIZE) + "]");
+            }
+        });
+        parser.AddOption("--max-code-len", [&options](const std::string& value) {
+            options.max_code_length = ArgsParser::ParseSize(value);
+            if (options.max_code_length < MIN_MAX_CODE_LENGTH || options.max_code_length > Bits::MAX_SIZE) {
+                throw BadArgumentsError("Maximal code length must be in [" + std::to_string(MIN_MAX_CODE_LENGTH) +
+                                        "; " + std::to_string(Bits::MAX_SIZE) + "]");
+            }
+        });
+        std::string stdin_name = "stdin";
+        parser.AddOption("--name", [&stdin_name](const std::string& value) { stdin_name = value; });
+        auto args = parser.Parse(argc, argv, 2);
+        if (args.size() >= 2) {
+            std::string archive = args[0];
+            std::vector<std::filesystem::path> files(args.begin() + 1, args.end());
+            bool from_stdin = std::find(files.begin(), files.end(), "-") != files.end();
+            if (from_stdin && files.size() > 1) {
+                throw BadArgumentsError("Standard input is archived alone");
+            }
+            std::ofstream file_archive_stream;
+            std::ostream* archive_stream = &std::cout;
+            if (archive != "-") {
+                std::cout << "Archive to \"" + archive + "\"\n";
+                file_archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit);
+                file_archive_stream.open(archive, std::ios::binary);
+                archive_stream = &file_archive_stream;
+            }
+            if (from_stdin) {
+                ArchiveStream(std::cin, stdin_name, *archive_stream, options);
+            } else {
+                Archive(files, *archive_stream, options);
+            }
+            // standard output has no exceptions enabled, and its buffered bytes may fail to be written as well
+            if (!archive_stream->flush()) {
+                throw std::runtime_error("Can't write archive to standard output");
+            }
+        } else {
+            throw BadArgumentsError("Unvalid number of arguments");
+        }
+    } else if (strcmp(argv[1], "-l") == 0) {
+        UnarchiveOptions options;
+        parser.AddFlag("--no-mmap", [&options] { options.use_mmap = false; });
+        auto args = parser.Parse(argc, argv, 2);
+        if (args.size() == 1) {
+            std::cout << std::setw(12) << "Size" << std::setw(12) << "Archived" << "  Name\n";
+            for (const auto& member : ListArchive(std::filesystem::path(args[0]), options)) {
+                std::cout << std::setw(12) << member.original_size << std::setw(12) << member.archived_size << "  "
+                          << member.name << "\n";
+            }
         } else {
             throw BadArgumentsError("Unvalid number of arguments");
         }
@@ -55,7 +174,7 @@ int main(int argc, char** argv) {
         std::cout << "Bad arguments: " << e.what() << "\n";
         PrintHelp();
     } catch (std::exception& e) {
-        std::cout << "Error while processing: " << e.what() << "\n";
+        std::cerr << "Error while processing: " << e.what() << "\n";
     }
     return 0;
 }
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+class BadArgumentsError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Parser of command line options mixed with positional arguments
+ *
+ * Option is either a flag, or takes the next argument as its value, or takes all following arguments
+ * up to the next option.
+ */
+class ArgsParser {
+public:
+    void AddFlag(std::string name, std::function<void()> on_flag) {
+        options_[std::move(name)] = {Kind::FLAG, [on_flag = std::move(on_flag)](const std::string &) { on_flag(); }};
+    }
+
+    void AddOption(std::string name, std::function<void(const std::string &)> on_value) {
+        options_[std::move(name)] = {Kind::VALUE, std::move(on_value)};
+    }
+
+    void AddMultiOption(std::string name, std::function<void(const std::string &)> on_value) {
+        options_[std::move(name)] = {Kind::MULTI_VALUE, std::move(on_value)};
+    }
+
+    /**
+     * @return positional arguments
+     */
+    std::vector<std::string> Parse(int argc, char **argv, int first) {
+        std::vector<std::string> positional;
+        for (int i = first; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (!IsOption(arg)) {
+                positional.push_back(std::move(arg));
+                continue;
+            }
+            auto option = options_.find(arg);
+            if (option == options_.end()) {
+                throw BadArgumentsError("Unknown option " + arg);
+            }
+            const auto &[kind, on_value] = option->second;
+            if (kind == Kind::FLAG) {
+                on_value({});
+            } else if (kind == Kind::VALUE) {
+                if (i + 1 == argc) {
+                    throw BadArgumentsError("No value for " + arg);
+                }
+                on_value(argv[++i]);
+            } else {
+                if (i + 1 == argc || IsOption(argv[i + 1])) {
+                    throw BadArgumentsError("No value for " + arg);
+                }
+                while (i + 1 < argc && !IsOption(argv[i + 1])) {
+                    on_value(argv[++i]);
+                }
+            }
+        }
+        return positional;
+    }
+
+    static size_t ParseSize(const std::string &arg) {
+        try {
+            size_t pos = 0;
+            size_t result = std::stoull(arg, &pos);
+            if (pos != arg.size() || arg.front() == '-') {
+                throw BadArgumentsError("Invalid number " + arg);
+            }
+            return result;
+        } catch (std::logic_error &) {
+            throw BadArgumentsError("Invalid number " + arg);
+        }
+    }
+
+private:
+    enum class Kind {
+        FLAG,
+        VALUE,
+        MULTI_VALUE,
+    };
+
+    static bool IsOption(const std::string &arg) {
+        return arg.size() > 1 && arg.front() == '-';
+    }
+
+    std::map<std::string, std::pair<Kind, std::function<void(const std::string &)>>> options_;
+};
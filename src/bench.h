@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/**
+ * @brief runs `func` `repeats` times and returns the best wall time in seconds
+ */
+template <typename F>
+double MeasureSeconds(F&& func, size_t repeats = 3) {
+    double best = 0;
+    for (size_t i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+inline void PrintThroughput(const std::string& name, size_t bytes, double seconds) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds * 1000 << " ms " << std::setw(10)
+              << static_cast<double>(bytes) / seconds / (1 << 20) << " MiB/s\n";
+}
@@ -0,0 +1,99 @@
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "adaptive_haffman.h"
+#include "bench.h"
+#include "blocks.h"
+#include "histogram.h"
+
+static std::vector<char> MakeSkewed(size_t size, double p, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::geometric_distribution<int> distribution(p);
+    std::vector<char> data(size);
+    for (auto &c : data) {
+        c = static_cast<char>('a' + distribution(gen) % 96);
+    }
+    return data;
+}
+
+static std::vector<char> MakeUniform(size_t size) {
+    std::mt19937 gen(0);
+    std::vector<char> data(size);
+    for (auto &c : data) {
+        c = static_cast<char>(gen());
+    }
+    return data;
+}
+
+/**
+ * @brief codes every piece of `data` of `piece_size` bytes independently, like tiny files or blocks
+ */
+static void Compare(const std::string &name, const std::vector<char> &data, size_t piece_size) {
+    std::vector<std::span<const char>> pieces;
+    for (size_t first = 0; first < data.size(); first += piece_size) {
+        pieces.push_back(std::span(data).subspan(first, std::min(piece_size, data.size() - first)));
+    }
+
+    std::vector<std::vector<char>> static_payloads(pieces.size());
+    double static_encode = MeasureSeconds([&] {
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            SymbolsCounter counter;
+            CountBytes(pieces[i].data(), pieces[i].data() + pieces[i].size(), counter);
+            static_payloads[i] = EncodeBlock(pieces[i], BlockTable(counter, DEFAULT_MAX_CODE_LENGTH), true);
+        }
+    });
+    std::vector<char> decoded(piece_size);
+    double static_decode = MeasureSeconds([&] {
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            SpanByteSource source(static_payloads[i]);
+            BitsIStream stream(source);
+            DecodeBlock(stream, ReadCode(stream), decoded.data(), pieces[i].size());
+        }
+    });
+
+    std::vector<std::vector<char>> adaptive_payloads(pieces.size());
+    double adaptive_encode = MeasureSeconds([&] {
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            adaptive_payloads[i] = EncodeAdaptiveBlock(pieces[i]);
+        }
+    });
+    double adaptive_decode = MeasureSeconds([&] {
+        for (size_t i = 0; i < pieces.size(); ++i) {
+            SpanByteSource source(adaptive_payloads[i]);
+            BitsIStream stream(source);
+            DecodeAdaptiveBlock(stream, decoded.data(), pieces[i].size());
+        }
+    });
+
+    auto ratio = [&data](const std::vector<std::vector<char>> &payloads) {
+        size_t size = 0;
+        for (const auto &payload : payloads) {
+            size += payload.size();
+        }
+        return static_cast<double>(size) / static_cast<double>(data.size());
+    };
+    std::string suffix = name + ", " + std::to_string(piece_size) + " B pieces";
+    std::cout << std::fixed << std::setprecision(4) << suffix << ": static ratio " << ratio(static_payloads)
+              << ", adaptive ratio " << ratio(adaptive_payloads) << "\n";
+    PrintThroughput("static encode", data.size(), static_encode);
+    PrintThroughput("static decode", data.size(), static_decode);
+    PrintThroughput("adaptive encode", data.size(), adaptive_encode);
+    PrintThroughput("adaptive decode", data.size(), adaptive_decode);
+}
+
+int main() {
+    const size_t size = 16 << 20;
+    auto text = MakeSkewed(size, 0.15, 1);
+    auto skewed = MakeSkewed(size, 0.6, 2);
+    auto uniform = MakeUniform(size);
+    for (size_t piece_size : {256, 4 << 10, 1 << 20}) {
+        Compare("text", text, piece_size);
+        Compare("skewed", skewed, piece_size);
+        Compare("uniform", uniform, piece_size);
+    }
+    return 0;
+}
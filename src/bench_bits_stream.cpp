@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bits_stream.h"
+
+/**
+ * @brief bit-at-a-time writer BitsOStream used to be, kept as a baseline
+ */
+template <class OStreamT>
+class LegacyBitsOStream {
+public:
+    explicit LegacyBitsOStream(OStreamT& stream) : stream_(stream) {
+    }
+
+    LegacyBitsOStream& operator<<(Bit bit) {
+        if (bit == Bit::ONE) {
+            buffer_ |= (1 << (8 - 1 - buffer_count_));
+        }
+        if (++buffer_count_ == 8) {
+            stream_.put(buffer_);
+            buffer_count_ = 0;
+            buffer_ = 0;
+        }
+        return *this;
+    }
+
+    void Flush() {
+        if (buffer_count_ > 0) {
+            stream_.put(buffer_);
+        }
+        stream_.flush();
+    }
+
+private:
+    uint8_t buffer_ = 0;
+    unsigned buffer_count_ = 0;
+    OStreamT& stream_;
+};
+
+/**
+ * @brief byte-at-a-time reader BitsIStream used to be, kept as a baseline
+ */
+template <class IStreamT>
+class LegacyBitsIStream {
+public:
+    explicit LegacyBitsIStream(IStreamT& stream) : stream_(stream) {
+    }
+
+    LegacyBitsIStream& operator>>(Bit& bit) {
+        if (buffer_count_ == 0) {
+            buffer_ = stream_.get();
+        }
+        bit = static_cast<Bit>((buffer_ >> (8 - 1 - buffer_count_)) & 1);
+        if (++buffer_count_ == 8) {
+            buffer_count_ = 0;
+        }
+        return *this;
+    }
+
+private:
+    uint8_t buffer_ = 0;
+    unsigned buffer_count_ = 0;
+    IStreamT& stream_;
+};
+
+int main() {
+    const size_t codes_count = 1 << 24;
+    std::mt19937 gen(0);
+    std::geometric_distribution<unsigned> length_distribution(0.25);
+    std::vector<std::pair<uint64_t, unsigned>> codes(codes_count);
+    size_t total_bits = 0;
+    for (auto& [value, length] : codes) {
+        length = std::min(1 + length_distribution(gen), 20u);
+        value = gen() & ((1u << length) - 1);
+        total_bits += length;
+    }
+
+    std::string legacy_output;
+    double legacy_seconds = MeasureSeconds([&] {
+        std::ostringstream stream;
+        LegacyBitsOStream bits_stream(stream);
+        for (auto [value, length] : codes) {
+            for (unsigned i = length; i > 0; --i) {
+                bits_stream << static_cast<Bit>((value >> (i - 1)) & 1);
+            }
+        }
+        bits_stream.Flush();
+        legacy_output = stream.str();
+    });
+
+    std::string word_output;
+    double word_seconds = MeasureSeconds([&] {
+        std::ostringstream stream;
+        BitsOStream bits_stream(stream);
+        for (auto [value, length] : codes) {
+            bits_stream.Write(value, length);
+        }
+        bits_stream.Flush();
+        word_output = stream.str();
+    });
+
+    if (legacy_output != word_output) {
+        std::cout << "Outputs differ\n";
+        return 1;
+    }
+    uint64_t legacy_sum = 0;
+    double legacy_read_seconds = MeasureSeconds([&] {
+        std::istringstream stream(word_output);
+        LegacyBitsIStream bits_stream(stream);
+        legacy_sum = 0;
+        for (auto [value, length] : codes) {
+            uint64_t read = 0;
+            for (unsigned i = 0; i < length; ++i) {
+                Bit bit;
+                bits_stream >> bit;
+                read = (read << 1) | static_cast<uint64_t>(bit);
+            }
+            legacy_sum += read;
+        }
+    });
+
+    uint64_t word_sum = 0;
+    double word_read_seconds = MeasureSeconds([&] {
+        std::istringstream stream(word_output);
+        BitsIStream bits_stream(stream);
+        word_sum = 0;
+        for (auto [value, length] : codes) {
+            word_sum += bits_stream.Read(length);
+        }
+    });
+
+    if (legacy_sum != word_sum) {
+        std::cout << "Readers differ\n";
+        return 1;
+    }
+    PrintThroughput("bit-at-a-time writer", total_bits / 8, legacy_seconds);
+    PrintThroughput("64-bit word writer", total_bits / 8, word_seconds);
+    PrintThroughput("byte-at-a-time reader", total_bits / 8, legacy_read_seconds);
+    PrintThroughput("block refill reader", total_bits / 8, word_read_seconds);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "archive.h"
+#include "args_parser.h"
+#include "bench.h"
+#include "unarchive.h"
+
+/**
+ * @brief writes `size` bytes made of 4 MiB segments with different distributions, like a tar of mixed files
+ */
+static void MakeFile(const std::filesystem::path &path, size_t size) {
+    std::ofstream stream(path, std::ios::binary);
+    std::mt19937 gen(0);
+    std::vector<char> segment(4 << 20);
+    for (size_t written = 0, index = 0; written < size; written += segment.size(), ++index) {
+        std::geometric_distribution<int> distribution(0.05 + 0.1 * static_cast<double>(index % 4));
+        char first = static_cast<char>(index % 3 == 0 ? 'a' : 0x80);
+        for (auto &c : segment) {
+            c = static_cast<char>(first + distribution(gen) % 96);
+        }
+        stream.write(segment.data(), static_cast<std::streamsize>(std::min(segment.size(), size - written)));
+    }
+}
+
+/**
+ * @brief usage: bench_blocks [size_in_bytes], 64 MiB by default
+ */
+int main(int argc, char **argv) {
+    size_t size = argc > 1 ? ArgsParser::ParseSize(argv[1]) : size_t{64} << 20;
+
+    auto directory = std::filesystem::temp_directory_path() / "bench_blocks";
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+    const std::filesystem::path input = directory / "input";
+    const std::filesystem::path archive = directory / "archive";
+    MakeFile(input, size);
+
+    std::vector<size_t> threads_list = {1};
+    if (std::thread::hardware_concurrency() > 1) {
+        threads_list.push_back(std::thread::hardware_concurrency());
+    }
+
+    Archive({input}, archive);
+    std::cout << "stream format ratio " << std::fixed << std::setprecision(4)
+              << static_cast<double>(std::filesystem::file_size(archive)) / static_cast<double>(size) << "\n";
+    for (size_t block_size : {4 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+        for (size_t threads : threads_list) {
+            ArchiveOptions archive_options;
+            archive_options.format = ArchiveFormat::BLOCKS;
+            archive_options.block_size = block_size;
+            archive_options.threads = threads;
+            double archive_seconds = MeasureSeconds([&] { Archive({input}, archive, archive_options); });
+
+            UnarchiveOptions unarchive_options;
+            unarchive_options.threads = threads;
+            double unarchive_seconds = MeasureSeconds([&] { Unarchive(archive, unarchive_options); });
+
+            std::string suffix = std::to_string(block_size >> 10);
+            suffix.append(" KiB blocks, ").append(std::to_string(threads)).append(" threads");
+            std::cout << "block format ratio, " << suffix << " " << std::fixed << std::setprecision(4)
+                      << static_cast<double>(std::filesystem::file_size(archive)) / static_cast<double>(size) << "\n";
+            PrintThroughput(std::string("archive ").append(suffix), size, archive_seconds);
+            PrintThroughput(std::string("unarchive ").append(suffix), size, unarchive_seconds);
+        }
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "code_lengths.h"
+#include "constants.h"
+#include "haffman_codes.h"
+#include "symbols_counter.h"
+
+/**
+ * @brief counters of small files: `symbols` distinct bytes with Zipf-like counts plus the special symbols
+ */
+static std::vector<SymbolsCounter> MakeCounters(size_t files, size_t symbols, size_t file_size) {
+    std::mt19937 gen(0);
+    std::vector<SymbolsCounter> counters(files);
+    for (auto &counter : counters) {
+        std::vector<double> weights(symbols);
+        for (size_t i = 0; i < symbols; ++i) {
+            weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 1.1);
+        }
+        std::discrete_distribution<size_t> distribution(weights.begin(), weights.end());
+        size_t offset = gen() % (256 - symbols + 1);
+        for (size_t i = 0; i < file_size; ++i) {
+            ++counter[offset + distribution(gen)];
+        }
+        counter[FILENAME_END] = 1;
+        counter[ONE_MORE_FILE] = 1;
+        counter[ARCHIVE_END] = 1;
+    }
+    return counters;
+}
+
+static void PrintPerTable(const std::string &name, size_t tables, double seconds) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds / static_cast<double>(tables) * 1e6 << " us per table\n";
+}
+
+int main() {
+    const size_t files = 2000;
+    std::pair<const char *, std::vector<SymbolsCounter>> inputs[] = {
+        {"text 4 KiB", MakeCounters(files, 64, 4 << 10)},
+        {"binary 64 KiB", MakeCounters(files, 256, 64 << 10)},
+    };
+    for (const auto &[input_name, counters] : inputs) {
+        size_t checksum = 0;
+        double trie_seconds = MeasureSeconds([&] {
+            for (const auto &counter : counters) {
+                checksum += TrieHaffmanCodeLengths(counter).size();
+            }
+        });
+        PrintPerTable(std::string(input_name) + ", trie lengths", counters.size(), trie_seconds);
+
+        double flat_seconds = MeasureSeconds([&] {
+            for (const auto &counter : counters) {
+                checksum += HaffmanCodeLengths(counter).size();
+            }
+        });
+        PrintPerTable(std::string(input_name) + ", flat lengths", counters.size(), flat_seconds);
+
+        double build_seconds = MeasureSeconds([&] {
+            for (const auto &counter : counters) {
+                checksum += BuildCodes(counter).size();
+            }
+        });
+        PrintPerTable(std::string(input_name) + ", BuildCodes", counters.size(), build_seconds);
+
+        if (checksum == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bits_stream.h"
+#include "blocks.h"
+#include "decode_table.h"
+#include "haffman_codes.h"
+#include "symbols_counter.h"
+#include "trie.h"
+
+using HaffmanTrieNode = TrieNode<NineBits, 2>;
+using HaffmanFlatTrie = FlatTrie<NineBits, 2, uint16_t>;
+
+/**
+ * @brief bit-at-a-time trie walk ReadEncodedSymbol used to do, kept as a baseline
+ */
+template <typename StreamT>
+static NineBits TrieDecode(BitsIStream<StreamT> &stream, const HaffmanTrieNode &root) {
+    const HaffmanTrieNode *now_node = &root;
+    while (now_node != nullptr && !now_node->IsTerminal()) {
+        Bit b;
+        stream >> b;
+        now_node = now_node->GetChild(static_cast<size_t>(b));
+    }
+    if (now_node == nullptr) {
+        throw std::runtime_error("Not find symbol");
+    }
+    return now_node->Value();
+}
+
+/**
+ * @brief the same walk over FlatTrie
+ */
+template <typename StreamT>
+static NineBits FlatTrieDecode(BitsIStream<StreamT> &stream, const HaffmanFlatTrie &trie) {
+    auto node = trie.Root();
+    while (node != HaffmanFlatTrie::NO_NODE && !trie.IsTerminal(node)) {
+        Bit b;
+        stream >> b;
+        node = trie.GetChild(node, static_cast<size_t>(b));
+    }
+    if (node == HaffmanFlatTrie::NO_NODE) {
+        throw std::runtime_error("Not find symbol");
+    }
+    return trie.Value(node);
+}
+
+/**
+ * @brief bytes with Zipf-like frequencies, roughly resembling text
+ */
+static std::vector<NineBits> MakeMessage(size_t size) {
+    std::vector<double> weights(256);
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), 1.1);
+    }
+    std::mt19937 gen(0);
+    std::discrete_distribution<uint16_t> distribution(weights.begin(), weights.end());
+    std::vector<NineBits> message(size);
+    for (NineBits &symbol : message) {
+        symbol = static_cast<NineBits>(distribution(gen));
+    }
+    return message;
+}
+
+int main() {
+    auto message = MakeMessage(1 << 23);
+    SymbolsCounter counter;
+    for (NineBits symbol : message) {
+        ++counter[symbol];
+    }
+    SortedHaffmanCodes sorted_codes = BuildCodes(counter);
+    EncodeTable codes(sorted_codes);
+
+    std::ostringstream encoded_stream;
+    BitsOStream bits_ostream(encoded_stream);
+    for (NineBits symbol : message) {
+        bits_ostream << codes[symbol];
+    }
+    bits_ostream.Flush();
+    const std::string encoded = encoded_stream.str();
+
+    HaffmanTrieNode trie(false);
+    HaffmanFlatTrie flat_trie(2 * sorted_codes.size());
+    std::vector<NineBits> symbols;
+    std::vector<size_t> count_with_lengths;
+    for (const auto &[symbol, code] : sorted_codes) {
+        std::vector<size_t> way;
+        for (size_t i = 0; i < code.Size(); ++i) {
+            way.push_back(static_cast<size_t>(code[i]));
+        }
+        trie.AddWay(way.begin(), way.end(), symbol);
+        flat_trie.AddWay(way.begin(), way.end(), symbol);
+        symbols.push_back(symbol);
+        count_with_lengths.resize(code.Size(), 0);
+        ++count_with_lengths.back();
+    }
+    DecodeTable table(symbols, count_with_lengths);
+
+    std::vector<NineBits> decoded(message.size());
+    double trie_seconds = MeasureSeconds([&] {
+        std::istringstream stream(encoded);
+        BitsIStream bits_istream(stream);
+        for (NineBits &symbol : decoded) {
+            symbol = TrieDecode(bits_istream, trie);
+        }
+    });
+    if (decoded != message) {
+        std::cout << "Trie decoding failed\n";
+        return 1;
+    }
+
+    decoded.assign(message.size(), NineBits{0});
+    double flat_trie_seconds = MeasureSeconds([&] {
+        std::istringstream stream(encoded);
+        BitsIStream bits_istream(stream);
+        for (NineBits &symbol : decoded) {
+            symbol = FlatTrieDecode(bits_istream, flat_trie);
+        }
+    });
+    if (decoded != message) {
+        std::cout << "Flat trie decoding failed\n";
+        return 1;
+    }
+
+    decoded.assign(message.size(), NineBits{0});
+    double table_seconds = MeasureSeconds([&] {
+        std::istringstream stream(encoded);
+        BitsIStream bits_istream(stream);
+        for (NineBits &symbol : decoded) {
+            symbol = table.Decode(bits_istream);
+        }
+    });
+    if (decoded != message) {
+        std::cout << "Table decoding failed\n";
+        return 1;
+    }
+
+    std::vector<char> decoded_bytes(message.size());
+    double bytes_seconds = MeasureSeconds([&] {
+        std::istringstream stream(encoded);
+        BitsIStream bits_istream(stream);
+        DecodeBlock(bits_istream, table, decoded_bytes.data(), decoded_bytes.size());
+    });
+    for (size_t i = 0; i < message.size(); ++i) {
+        if (static_cast<uint8_t>(decoded_bytes[i]) != static_cast<uint16_t>(message[i])) {
+            std::cout << "Several bytes per lookup decoding failed\n";
+            return 1;
+        }
+    }
+
+    PrintThroughput("trie walk", message.size(), trie_seconds);
+    PrintThroughput("flat trie walk", message.size(), flat_trie_seconds);
+    PrintThroughput("lookup table", message.size(), table_seconds);
+    PrintThroughput("lookup table, several bytes per lookup", message.size(), bytes_seconds);
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "histogram.h"
+#include "symbols_counter.h"
+#include "thread_pool.h"
+
+static std::vector<char> MakeUniform(size_t size) {
+    std::mt19937 gen(0);
+    std::vector<char> data(size);
+    for (auto &c : data) {
+        c = static_cast<char>(gen());
+    }
+    return data;
+}
+
+static std::vector<char> MakeSkewed(size_t size) {
+    std::mt19937 gen(0);
+    std::geometric_distribution<int> distribution(0.2);
+    std::vector<char> data(size);
+    for (auto &c : data) {
+        c = static_cast<char>(distribution(gen));
+    }
+    return data;
+}
+
+/**
+ * @brief long runs of zeros with rare other bytes, like sparse binary dumps
+ */
+static std::vector<char> MakeRuns(size_t size) {
+    std::mt19937 gen(0);
+    std::vector<char> data(size, 0);
+    for (size_t i = 0; i < size; i += 1 + gen() % 4096) {
+        data[i] = static_cast<char>(gen());
+    }
+    return data;
+}
+
+int main() {
+    const size_t size = 64 << 20;
+    std::pair<const char *, std::vector<char>> inputs[] = {
+        {"uniform", MakeUniform(size)}, {"skewed", MakeSkewed(size)}, {"runs", MakeRuns(size)}};
+    for (const auto &[input_name, data] : inputs) {
+        SymbolsCounter expected;
+        double naive_seconds = MeasureSeconds([&] {
+            expected = SymbolsCounter();
+            for (char c : data) {
+                ++expected[CharToNineBits(c)];
+            }
+        });
+        PrintThroughput(std::string(input_name) + ", single table", size, naive_seconds);
+
+        SymbolsCounter counter;
+        double seconds = MeasureSeconds([&] {
+            counter = SymbolsCounter();
+            CountBytes(data.data(), data.data() + data.size(), counter);
+        });
+        if (counter.GetUnder() != expected.GetUnder()) {
+            std::cout << "Counts differ\n";
+            return 1;
+        }
+        PrintThroughput(std::string(input_name) + ", four tables", size, seconds);
+    }
+
+    const auto &[input_name, data] = inputs[1];
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        ThreadPool pool(threads);
+        double seconds = MeasureSeconds([&] {
+            SymbolsCounter counter;
+            ParallelCountBytes(data.data(), data.data() + data.size(), counter, pool, 1 << 16);
+        });
+        PrintThroughput(std::string(input_name) + ", " + std::to_string(threads) + " threads", size, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include <cmath>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "blocks.h"
+#include "histogram.h"
+
+/**
+ * @brief bytes with Zipf-like frequencies of exponent `exponent`, higher is more skewed
+ */
+static std::vector<char> MakeZipf(size_t size, double exponent) {
+    std::vector<double> weights(256);
+    for (size_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+    }
+    std::mt19937 gen(0);
+    std::discrete_distribution<int> distribution(weights.begin(), weights.end());
+    std::vector<char> data(size);
+    for (char &c : data) {
+        c = static_cast<char>(distribution(gen));
+    }
+    return data;
+}
+
+/**
+ * @brief decodes 1 MiB blocks of `data` coded to a single stream and to interleaved streams
+ */
+static void Compare(const std::string &name, const std::vector<char> &data) {
+    const size_t block_size = 1 << 20;
+    std::vector<std::span<const char>> blocks;
+    std::vector<BlockTable> tables;
+    for (size_t first = 0; first < data.size(); first += block_size) {
+        blocks.push_back(std::span(data).subspan(first, std::min(block_size, data.size() - first)));
+        SymbolsCounter counter;
+        CountBytes(blocks.back().data(), blocks.back().data() + blocks.back().size(), counter);
+        tables.emplace_back(counter, DEFAULT_MAX_CODE_LENGTH);
+    }
+    std::vector<DecodeTable> decode_tables;
+    std::vector<std::vector<char>> single;
+    std::vector<std::vector<char>> interleaved;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        single.push_back(EncodeBlock(blocks[i], tables[i], true));
+        interleaved.push_back(EncodeInterleavedBlock(blocks[i], tables[i], false));
+        SpanByteSource source(single.back());
+        BitsIStream stream(source);
+        decode_tables.push_back(ReadCode(stream));
+    }
+
+    std::vector<char> decoded(block_size);
+    bool equal = true;
+    double single_seconds = MeasureSeconds([&] {
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            SpanByteSource source(single[i]);
+            BitsIStream stream(source);
+            ReadCode(stream);
+            DecodeBlock(stream, decode_tables[i], decoded.data(), blocks[i].size());
+            equal = equal && std::equal(blocks[i].begin(), blocks[i].end(), decoded.begin());
+        }
+    });
+    double interleaved_seconds = MeasureSeconds([&] {
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            DecodeInterleavedBlock(interleaved[i], decode_tables[i], decoded.data(), blocks[i].size());
+            equal = equal && std::equal(blocks[i].begin(), blocks[i].end(), decoded.begin());
+        }
+    });
+    if (!equal) {
+        std::cout << "Decoded content differs\n";
+    }
+    PrintThroughput(name + ", single stream", data.size(), single_seconds);
+    PrintThroughput(name + ", " + std::to_string(INTERLEAVED_STREAMS) + " interleaved streams", data.size(),
+                    interleaved_seconds);
+}
+
+int main() {
+    const size_t size = 32 << 20;
+    Compare("zipf 0.7", MakeZipf(size, 0.7));
+    Compare("zipf 1.1", MakeZipf(size, 1.1));
+    Compare("zipf 2.0", MakeZipf(size, 2.0));
+    return 0;
+}
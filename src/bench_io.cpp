@@ -0,0 +1,67 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "archive.h"
+#include "args_parser.h"
+#include "bench.h"
+#include "unarchive.h"
+
+/**
+ * @brief writes `size` bytes with skewed distribution, generated by blocks to keep memory low
+ */
+static void MakeFile(const std::filesystem::path &path, size_t size) {
+    std::ofstream stream(path, std::ios::binary);
+    std::mt19937 gen(0);
+    std::geometric_distribution<int> distribution(0.1);
+    std::vector<char> block(1 << 20);
+    for (auto &c : block) {
+        c = static_cast<char>('a' + distribution(gen) % 64);
+    }
+    for (size_t written = 0; written < size; written += block.size()) {
+        stream.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), size - written)));
+    }
+}
+
+/**
+ * @brief usage: bench_io [size_in_bytes...], sizes from 4 KB to 256 MB by default
+ */
+int main(int argc, char **argv) {
+    std::vector<size_t> sizes = {4 << 10, 256 << 10, 16 << 20, 256 << 20};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; ++i) {
+            sizes.push_back(ArgsParser::ParseSize(argv[i]));
+        }
+    }
+
+    auto directory = std::filesystem::temp_directory_path() / "bench_io";
+    std::filesystem::create_directories(directory);
+    std::filesystem::current_path(directory);
+    const std::filesystem::path input = directory / "input";
+    const std::filesystem::path archive = directory / "archive";
+
+    for (size_t size : sizes) {
+        MakeFile(input, size);
+        size_t repeats = size < (16 << 20) ? 20 : 3;
+        for (bool use_mmap : {false, true}) {
+            ArchiveOptions archive_options;
+            archive_options.use_mmap = use_mmap;
+            double archive_seconds = MeasureSeconds([&] { Archive({input}, archive, archive_options); }, repeats);
+
+            UnarchiveOptions unarchive_options;
+            unarchive_options.use_mmap = use_mmap;
+            double unarchive_seconds = MeasureSeconds([&] { Unarchive(archive, unarchive_options); }, repeats);
+
+            std::string suffix = std::to_string(size);
+            suffix.append(use_mmap ? " B, mmap" : " B, stream");
+            PrintThroughput(std::string("archive ").append(suffix), size, archive_seconds);
+            PrintThroughput(std::string("unarchive ").append(suffix), size, unarchive_seconds);
+        }
+    }
+    std::filesystem::remove_all(directory);
+    return 0;
+}
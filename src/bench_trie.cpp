@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+#include "bench.h"
+#include "haffman_codes.h"
+#include "symbols_counter.h"
+#include "trie.h"
+
+using HaffmanTrieNode = TrieNode<NineBits, 2>;
+using HaffmanFlatTrie = FlatTrie<NineBits, 2, uint16_t>;
+
+/**
+ * @brief ways of canonical codes for random counts of all 9-bit symbols
+ */
+static std::vector<std::pair<NineBits, std::vector<size_t>>> MakeWays(std::mt19937 &gen) {
+    SymbolsCounter counter;
+    for (size_t i = 0; i < counter.size(); ++i) {
+        counter[i] = 1 + gen() % 1000;
+    }
+    std::vector<std::pair<NineBits, std::vector<size_t>>> ways;
+    for (const auto &[symbol, code] : BuildCodes(counter)) {
+        std::vector<size_t> way;
+        for (size_t i = 0; i < code.Size(); ++i) {
+            way.push_back(static_cast<size_t>(code[i]));
+        }
+        ways.emplace_back(symbol, std::move(way));
+    }
+    return ways;
+}
+
+static size_t HeapInUse() {
+    return mallinfo2().uordblks;
+}
+
+static void PrintMemory(const std::string &name, size_t bytes, size_t nodes) {
+    std::cout << std::left << std::setw(40) << name << std::right << std::setw(10) << bytes / 1024 << " KiB "
+              << std::fixed << std::setprecision(1) << std::setw(10)
+              << static_cast<double>(bytes) / static_cast<double>(nodes) << " bytes per node\n";
+}
+
+int main() {
+    const size_t tries = 2000;
+    std::mt19937 gen(0);
+    std::vector<std::vector<std::pair<NineBits, std::vector<size_t>>>> all_ways;
+    size_t nodes = 0;
+    for (size_t i = 0; i < tries; ++i) {
+        all_ways.push_back(MakeWays(gen));
+        nodes += 2 * all_ways.back().size() - 1;
+    }
+
+    std::vector<std::unique_ptr<HaffmanTrieNode>> pointer_tries;
+    size_t heap_before = HeapInUse();
+    double pointer_build_seconds = MeasureSeconds(
+        [&] {
+            for (const auto &ways : all_ways) {
+                auto trie = std::make_unique<HaffmanTrieNode>(false);
+                for (const auto &[symbol, way] : ways) {
+                    trie->AddWay(way.begin(), way.end(), symbol);
+                }
+                pointer_tries.push_back(std::move(trie));
+            }
+        },
+        1);
+    size_t pointer_bytes = HeapInUse() - heap_before;
+
+    std::vector<HaffmanFlatTrie> flat_tries;
+    flat_tries.reserve(tries);
+    heap_before = HeapInUse();
+    double flat_build_seconds = MeasureSeconds(
+        [&] {
+            for (const auto &ways : all_ways) {
+                auto &trie = flat_tries.emplace_back(2 * ways.size());
+                for (const auto &[symbol, way] : ways) {
+                    trie.AddWay(way.begin(), way.end(), symbol);
+                }
+            }
+        },
+        1);
+    size_t flat_bytes = HeapInUse() - heap_before;
+
+    PrintMemory("pointer trie memory", pointer_bytes, nodes);
+    PrintMemory("flat trie memory", flat_bytes, nodes);
+    PrintThroughput("pointer trie build, nodes", nodes, pointer_build_seconds);
+    PrintThroughput("flat trie build, nodes", nodes, flat_build_seconds);
+
+    size_t pointer_depths = 0;
+    double pointer_walk_seconds = MeasureSeconds([&] {
+        pointer_depths = 0;
+        for (auto &trie : pointer_tries) {
+            trie->WalkTrie([&](const auto &way, NineBits) { pointer_depths += way.size(); });
+        }
+    });
+    size_t flat_depths = 0;
+    double flat_walk_seconds = MeasureSeconds([&] {
+        flat_depths = 0;
+        for (const auto &trie : flat_tries) {
+            trie.WalkTrie([&](const auto &way, NineBits) { flat_depths += way.size(); });
+        }
+    });
+    if (pointer_depths != flat_depths) {
+        std::cout << "Walks differ\n";
+        return 1;
+    }
+    PrintThroughput("pointer trie WalkTrie, nodes", nodes, pointer_walk_seconds);
+    PrintThroughput("flat trie WalkTrie, nodes", nodes, flat_walk_seconds);
+    return 0;
+}
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <algorithm>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 
 enum class Bit : uint8_t {
@@ -9,51 +9,56 @@ enum class Bit : uint8_t {
     ONE = 1,
 };
 
+/**
+ * @brief Code of at most MAX_SIZE bits packed into an integer
+ */
 class Bits {
 public:
-    inline Bits& operator++() {
-        for (auto it = code_.rbegin(); it != code_.rend(); ++it) {
-            if (*it == Bit::ONE) {
-                *it = Bit::ZERO;
-            } else {
-                *it = Bit::ONE;
-                return *this;
-            }
+    static constexpr size_t MAX_SIZE = 63;
+
+    constexpr Bits() = default;
+
+    constexpr Bits(uint64_t value, size_t size) : value_(value), size_(static_cast<uint8_t>(size)) {
+    }
+
+    inline Bits& operator++() noexcept {
+        if (++value_ == uint64_t{1} << size_) {
+            ++size_;  // executes almost never
         }
-        code_.emplace(code_.begin(), Bit::ONE);  // executes almost never
         return *this;
     }
     template <class size_t>
     inline Bits& operator<<=(size_t shift) noexcept {
-        code_.resize(code_.size() + shift, Bit::ZERO);
+        value_ <<= shift;
+        size_ += shift;
         return *this;
     }
     template <class size_t>
-    inline Bits operator<<(size_t shift) noexcept {
-        Bits result;
-        result.code_.assign(code_.size() + shift, Bit::ZERO);
-        std::copy(code_.begin(), code_.end(), result.code_.begin());
-        return result;
+    inline Bits operator<<(size_t shift) const noexcept {
+        Bits result = *this;
+        return result <<= shift;
     }
 
+    inline bool operator==(const Bits& other) const = default;
+
     inline size_t Size() const {
-        return code_.size();
+        return size_;
     }
 
     /**
-     * @brief starts at most significant bit
-     *
+     * @brief code with most significant bit first, occupies Size() least significant bits
      */
-    inline auto begin() const {  // NOLINT
-        return code_.begin();
+    inline uint64_t Value() const {
+        return value_;
     }
 
-    inline auto end() const {  // NOLINT
-        return code_.end();
+    inline Bit operator[](size_t i) const {
+        return static_cast<Bit>((value_ >> (size_ - 1 - i)) & 1);
     }
 
 private:
-    std::vector<Bit> code_;  // stores in big-endian format
+    uint64_t value_ = 0;
+    uint8_t size_ = 0;
 };
 
 inline std::ostream& operator<<(std::ostream& stream, Bit bit) {
@@ -61,8 +66,8 @@ inline std::ostream& operator<<(std::ostream& stream, Bit bit) {
 }
 
 inline std::ostream& operator<<(std::ostream& stream, const Bits& bits) {
-    for (auto b : bits) {
-        stream << b;
+    for (size_t i = 0; i < bits.Size(); ++i) {
+        stream << bits[i];
     }
     return stream;
 }
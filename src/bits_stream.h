@@ -1,13 +1,21 @@
 #pragma once
 
+#include <algorithm>
 #include <bit>
+#include <cstddef>
+#include <cstring>
 #include <exception>
 #include <ios>
 #include <iostream>
+#include <span>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 #include "nine_bits.h"
 #include "bits.h"
+#include "byte_sink.h"
+#include "byte_source.h"
 
 constexpr bool IsBigEndian = std::endian::native == std::endian::big;
 constexpr bool IsLittleEndian = std::endian::native == std::endian::little;
@@ -16,85 +24,255 @@ static_assert(IsBigEndian || IsLittleEndian);
 template <class OStreamT>
 class BitsOStream {
 public:
-    explicit BitsOStream(OStreamT& stream) : stream_(stream) {
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+    static constexpr unsigned WORD_BITS = 64;
+
+    /**
+     * @param stream is either ByteSink or std::ostream
+     */
+    explicit BitsOStream(OStreamT& stream) : sink_(stream), block_(BLOCK_SIZE) {
     }
 
     BitsOStream& operator<<(NineBits symbol) {
-        for (size_t i = 0; i < 9; ++i) {
-            *this << static_cast<Bit>(((static_cast<uint16_t>(symbol) >> (9 - 1 - i)) & 1) == 1);
+        return Write(static_cast<uint16_t>(symbol), 9);
+    }
+
+    BitsOStream& operator<<(const Bits& bits) {
+        return Write(bits.Value(), bits.Size());
+    }
+
+    BitsOStream& operator<<(Bit bit) {
+        return Write(static_cast<uint64_t>(bit), 1);
+    }
+
+    /**
+     * @brief writes `length` least significant bits of `value`, starting at most significant
+     *
+     * @param value must be less than 2^length
+     * @param length in [1; 64]
+     */
+    BitsOStream& Write(uint64_t value, unsigned length) {
+        if (length < free_bits_) {
+            free_bits_ -= length;
+            accumulator_ |= value << free_bits_;
+        } else {
+            length -= free_bits_;
+            accumulator_ |= value >> length;
+            PutWord(accumulator_);
+            free_bits_ = WORD_BITS - length;
+            accumulator_ = length == 0 ? 0 : value << free_bits_;
         }
         return *this;
     }
 
-    BitsOStream& operator<<(const Bits& bits) {
-        for (Bit bit : bits) {
-            *this << bit;
+    /**
+     * @brief writes first `bit_count` bits of `bytes`, which were produced by another BitsOStream
+     */
+    BitsOStream& WriteBits(std::span<const char> bytes, size_t bit_count) {
+        const char* data = bytes.data();
+        if (free_bits_ % 8 == 0) {
+            PutBytes(data, bit_count / 8);
+            data += bit_count / 8;
+            bit_count %= 8;
+        }
+        for (; bit_count >= WORD_BITS; bit_count -= WORD_BITS, data += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            if constexpr (IsLittleEndian) {
+                word = __builtin_bswap64(word);
+            }
+            Write(word, WORD_BITS);
+        }
+        if (bit_count > 0) {
+            uint64_t word = 0;
+            for (size_t i = 0; i < (bit_count + 7) / 8; ++i) {
+                word |= uint64_t{static_cast<uint8_t>(data[i])} << (WORD_BITS - 8 * (i + 1));
+            }
+            Write(word >> (WORD_BITS - bit_count), static_cast<unsigned>(bit_count));
         }
         return *this;
     }
 
+    /**
+     * @return number of bits written so far, padding added by Flush included
+     */
+    size_t WrittenBits() const {
+        return (flushed_bytes_ + block_size_) * 8 + (WORD_BITS - free_bits_);
+    }
+
+    /**
+     * @brief pads last byte with zeros and passes everything written to the stream
+     */
     void Flush() {
-        if (buffer_count_ > 0) {
-            stream_ << buffer_;
+        size_t bytes = (WORD_BITS - free_bits_ + 7) / 8;
+        for (size_t i = 0; i < bytes; ++i) {
+            block_[block_size_++] = static_cast<char>(accumulator_ >> (WORD_BITS - 8 * (i + 1)));
         }
-        stream_.flush();
+        accumulator_ = 0;
+        free_bits_ = WORD_BITS;
+        FlushBlock();
+        sink_.Flush();
     }
 
-    BitsOStream& operator<<(Bit bit) {
-        if (bit == Bit::ONE) {
-            if constexpr (IsBigEndian) {
-                buffer_ |= (1 << buffer_count_);
-            } else if constexpr (IsLittleEndian) {
-                buffer_ |= (1 << (8 - 1 - buffer_count_));
+private:
+    void PutWord(uint64_t word) {
+        if constexpr (IsLittleEndian) {
+            word = __builtin_bswap64(word);
+        }
+        std::memcpy(block_.data() + block_size_, &word, sizeof(word));
+        block_size_ += sizeof(word);
+        if (block_size_ == block_.size()) {
+            FlushBlock();
+        }
+    }
+
+    /**
+     * @brief writes whole bytes when stream is aligned to byte, most of them are copied without shifts
+     */
+    void PutBytes(const char* data, size_t size) {
+        for (; free_bits_ != WORD_BITS && size > 0; ++data, --size) {
+            Write(static_cast<uint8_t>(*data), 8);
+        }
+        // block is filled by whole words only
+        size_t words_size = size - size % sizeof(uint64_t);
+        if (block_size_ == 0 && words_size >= block_.size()) {
+            sink_.Write(data, words_size);
+            flushed_bytes_ += words_size;
+        } else {
+            for (size_t copied = 0; copied < words_size;) {
+                size_t part = std::min(words_size - copied, block_.size() - block_size_);
+                std::memcpy(block_.data() + block_size_, data + copied, part);
+                block_size_ += part;
+                copied += part;
+                if (block_size_ == block_.size()) {
+                    FlushBlock();
+                }
             }
         }
-        if (++buffer_count_ == 8) {
-            stream_.put(buffer_);
-            buffer_count_ = 0;
-            buffer_ = 0;
+        for (size_t i = words_size; i < size; ++i) {
+            Write(static_cast<uint8_t>(data[i]), 8);
         }
-        return *this;
     }
 
-private:
-    uint8_t buffer_ = 0;
-    unsigned buffer_count_ = 0;
-    OStreamT& stream_;
+    void FlushBlock() {
+        sink_.Write(block_.data(), block_size_);
+        flushed_bytes_ += block_size_;
+        block_size_ = 0;
+    }
+
+    uint64_t accumulator_ = 0;  // pending bits are stored starting from the most significant one
+    unsigned free_bits_ = WORD_BITS;
+    std::conditional_t<ByteSink<OStreamT>, OStreamT&, StreamByteSink<OStreamT>> sink_;
+    std::vector<char> block_;
+    size_t block_size_ = 0;
+    size_t flushed_bytes_ = 0;
 };
 
 template <class IStreamT>
 class BitsIStream {
 public:
-    explicit BitsIStream(IStreamT& stream) : stream_(stream) {
+    static constexpr unsigned WORD_BITS = 64;
+    static constexpr unsigned MAX_PEEK_BITS = WORD_BITS - 8;
+
+    /**
+     * @param stream is either ByteSource or std::istream
+     */
+    explicit BitsIStream(IStreamT& stream) : source_(stream) {
     }
 
     BitsIStream& operator>>(NineBits& symbol) {
-        symbol = {0};
-        for (size_t i = 0; i < 9; ++i) {
-            Bit bit;
-            *this >> bit;
-            symbol |= static_cast<NineBits>(bit) << (9 - 1 - i);
-        }
+        symbol = static_cast<NineBits>(Read(9));
         return *this;
     }
 
     BitsIStream& operator>>(Bit& bit) {
-        if (buffer_count_ == 0) {
-            buffer_ = stream_.get();
-        }
-        if constexpr (IsBigEndian) {
-            bit = static_cast<Bit>((buffer_ >> buffer_count_) & 1);
-        } else if constexpr (IsLittleEndian) {
-            bit = static_cast<Bit>((buffer_ >> (8 - 1 - buffer_count_)) & 1);
+        bit = static_cast<Bit>(Read(1));
+        return *this;
+    }
+
+    /**
+     * @brief returns next `count` bits without extracting them, bits after end of stream are zeros
+     *
+     * @param count in [1; MAX_PEEK_BITS]
+     */
+    uint64_t Peek(unsigned count) {
+        if (buffer_count_ < count) {
+            Refill();
         }
-        if (++buffer_count_ == 8) {
-            buffer_count_ = 0;
+        return buffer_ >> (WORD_BITS - count);
+    }
+
+    /**
+     * @brief extracts `count` bits, which must be peeked before
+     */
+    void Consume(unsigned count) {
+        if (count + padding_count_ > buffer_count_) {
+            throw std::runtime_error("Unexpected end of stream");
         }
-        return *this;
+        buffer_ <<= count;
+        buffer_count_ -= count;
+    }
+
+    /**
+     * @param count in [1; MAX_PEEK_BITS]
+     */
+    uint64_t Read(unsigned count) {
+        uint64_t result = Peek(count);
+        Consume(count);
+        return result;
+    }
+
+    /**
+     * @return number of bits extracted so far
+     */
+    size_t ReadBits() const {
+        return (source_bytes_ - (end_ - position_)) * 8 - (buffer_count_ - padding_count_);
     }
 
 private:
-    uint8_t buffer_ = 0;
+    /**
+     * @brief tops buffer up to at least MAX_PEEK_BITS bits
+     */
+    void Refill() {
+        if (end_ - position_ >= static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+            uint64_t word;
+            std::memcpy(&word, position_, sizeof(word));
+            if constexpr (IsLittleEndian) {
+                word = __builtin_bswap64(word);
+            }
+            // bits of the partially taken byte are taken again later at the same place, so OR keeps them
+            buffer_ |= word >> buffer_count_;
+            unsigned bytes = (WORD_BITS - 1 - buffer_count_) / 8;
+            position_ += bytes;
+            buffer_count_ += 8 * bytes;
+            return;
+        }
+        // block boundary or end of stream
+        while (buffer_count_ <= MAX_PEEK_BITS) {
+            if (position_ == end_ && !source_end_) {
+                auto block = source_.NextBlock();
+                position_ = block.data();
+                end_ = block.data() + block.size();
+                source_bytes_ += block.size();
+                source_end_ = block.empty();
+                continue;
+            }
+            if (position_ != end_) {
+                buffer_ |= static_cast<uint64_t>(static_cast<uint8_t>(*position_++))
+                           << (WORD_BITS - 8 - buffer_count_);
+            } else {
+                padding_count_ += 8;
+            }
+            buffer_count_ += 8;
+        }
+    }
+
+    uint64_t buffer_ = 0;  // bits are stored starting from the most significant one
     unsigned buffer_count_ = 0;
-    IStreamT& stream_;
+    unsigned padding_count_ = 0;
+    std::conditional_t<ByteSource<IStreamT>, IStreamT&, StreamByteSource<IStreamT>> source_;
+    const char* position_ = nullptr;
+    const char* end_ = nullptr;
+    size_t source_bytes_ = 0;
+    bool source_end_ = false;
 };
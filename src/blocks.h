@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "adaptive_haffman.h"
+#include "bits_stream.h"
+#include "byte_sink.h"
+#include "byte_source.h"
+#include "codes_io.h"
+#include "decode_table.h"
+#include "haffman_codes.h"
+#include "nine_bits.h"
+#include "symbols_counter.h"
+
+/**
+ * Block archive format (version 2)
+ *
+ * Archive starts with ARCHIVE_MAGIC; its first byte can't start an archive of version 1, whose first 9 bits are
+ * the symbols count not greater than 259. Then members follow, every one is aligned to byte:
+ * 1. MemberTag::MEMBER, 2 bytes of name length, name bytes
+ * 2. blocks of content, every one is a header of BLOCK_HEADER_SIZE bytes (method, raw size, payload size) followed
+ *    by payload; a block with BlockMethod::MEMBER_END ends the member
+ * The last member is followed by MemberTag::ARCHIVE_END. Integers are big-endian.
+ *
+ * Optional index follows ARCHIVE_END: for every member 2 bytes of name length, name, 8 bytes of member offset from
+ * the archive start, 8 bytes of original size and 8 bytes of member size in archive. It ends with a footer of
+ * INDEX_FOOTER_SIZE bytes: 8 bytes of index offset, 4 bytes of members count and INDEX_MAGIC. Archive without index
+ * ends with zero ARCHIVE_END tag, so it can't be taken for indexed one.
+ *
+ * Payload of a Haffman block is a bit stream of codes (as written by ArchiveCodes) unless the block reuses the
+ * previous table, which is of the previous member for the first block of a member, then encoded bytes, padded to
+ * byte with zeros. Payload of an adaptive Haffman block
+ * is just encoded bytes, see AdaptiveHaffmanTree. Payload of an order-1 block holds Haffman tables by previous byte,
+ * see ContextTables. Interleaved Haffman blocks differ from Haffman ones by codes: i-th byte is coded to stream
+ * i % INTERLEAVED_STREAMS, every stream is padded to byte, and sizes of all streams but the last one precede them
+ * as 4 bytes each, aligned to byte too. So their decoder decodes several bytes at once. Payload of a stored block is
+ * its content as is. Blocks are independent besides reused tables, so they are encoded and decoded in parallel.
+ */
+
+inline constexpr std::array<char, 4> ARCHIVE_MAGIC = {'\xFF', 'H', 'A', '\x02'};
+
+inline constexpr std::array<char, 4> INDEX_MAGIC = {'H', 'A', 'I', 'X'};
+inline constexpr size_t INDEX_FOOTER_SIZE = 8 + 4 + INDEX_MAGIC.size();
+
+inline constexpr size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+// payload of such a block fits 32 bits even with codes of Bits::MAX_SIZE
+inline constexpr size_t MAX_BLOCK_SIZE = size_t{1} << 28;
+inline constexpr size_t MAX_MEMBER_NAME_SIZE = std::numeric_limits<uint16_t>::max();
+
+enum class MemberTag : uint8_t {
+    ARCHIVE_END = 0,
+    MEMBER = 1,
+};
+
+enum class BlockMethod : uint8_t {
+    MEMBER_END = 0,
+    HAFFMAN = 1,
+    HAFFMAN_PREVIOUS_TABLE = 2,
+    ADAPTIVE_HAFFMAN = 3,
+    HAFFMAN_ORDER1 = 4,
+    INTERLEAVED_HAFFMAN = 5,
+    INTERLEAVED_HAFFMAN_PREVIOUS_TABLE = 6,
+    STORED = 7,
+};
+
+inline constexpr size_t INTERLEAVED_STREAMS = 4;
+static_assert(INTERLEAVED_STREAMS == 4, "decoder of interleaved blocks is unrolled for 4 streams");
+
+/**
+ * @brief the most bits an interleaved block takes beyond its table and codes: sizes of streams and padding of the
+ * table and the streams
+ */
+inline constexpr size_t INTERLEAVED_OVERHEAD_SIZE = 8 * (4 * (INTERLEAVED_STREAMS - 1) + 1 + INTERLEAVED_STREAMS);
+
+inline constexpr size_t ORDER1_CONTEXTS = 256;
+
+struct BlockHeader {
+    BlockMethod method;
+    uint32_t raw_size;
+    uint32_t payload_size;
+};
+
+inline constexpr size_t BLOCK_HEADER_SIZE = 9;
+
+template <typename StreamT>
+void WriteBlockHeader(BitsOStream<StreamT> &stream, const BlockHeader &header) {
+    stream.Write(static_cast<uint8_t>(header.method), 8);
+    stream.Write(header.raw_size, 32);
+    stream.Write(header.payload_size, 32);
+}
+
+template <typename SourceT>
+BlockHeader ReadBlockHeader(ByteReader<SourceT> &reader) {
+    BlockHeader header;
+    header.method = static_cast<BlockMethod>(reader.ReadUint(1));
+    header.raw_size = static_cast<uint32_t>(reader.ReadUint(4));
+    header.payload_size = static_cast<uint32_t>(reader.ReadUint(4));
+    // the largest tables and the longest codes for every byte
+    size_t max_tables_size = 9 * (2 + NINE_BITS_MAX + Bits::MAX_SIZE);
+    if (header.method == BlockMethod::HAFFMAN_ORDER1) {
+        max_tables_size = (1 + ORDER1_CONTEXTS) * (1 + max_tables_size);
+    } else if (header.method == BlockMethod::INTERLEAVED_HAFFMAN ||
+               header.method == BlockMethod::INTERLEAVED_HAFFMAN_PREVIOUS_TABLE) {
+        max_tables_size += INTERLEAVED_OVERHEAD_SIZE;
+    }
+    size_t max_payload_size =
+        header.method == BlockMethod::ADAPTIVE_HAFFMAN
+            ? (size_t{header.raw_size} * AdaptiveHaffmanTree::MAX_CODE_SIZE + 7) / 8
+            : (max_tables_size + size_t{header.raw_size} * Bits::MAX_SIZE + 7) / 8;
+    if (header.raw_size > MAX_BLOCK_SIZE || header.payload_size > max_payload_size ||
+        (header.method == BlockMethod::STORED && header.payload_size != header.raw_size)) {
+        throw std::runtime_error("Bad archive");
+    }
+    return header;
+}
+
+template <typename StreamT>
+void WriteMemberName(BitsOStream<StreamT> &stream, const std::string &name) {
+    if (name.size() > MAX_MEMBER_NAME_SIZE) {
+        throw std::runtime_error("Too long file name " + name);
+    }
+    stream.Write(static_cast<uint8_t>(MemberTag::MEMBER), 8);
+    stream.Write(name.size(), 16);
+    stream.WriteBits(name, 8 * name.size());
+}
+
+/**
+ * @brief reads name of the next member after its tag
+ */
+template <typename SourceT>
+std::string ReadMemberName(ByteReader<SourceT> &reader) {
+    std::string name(reader.ReadUint(2), '\0');
+    reader.Read(name.data(), name.size());
+    return name;
+}
+
+struct IndexEntry {
+    std::string name;
+    uint64_t offset;
+    uint64_t original_size;
+    uint64_t compressed_size;
+
+    bool operator==(const IndexEntry &) const = default;
+};
+
+/**
+ * @brief writes index and its footer, stream must be aligned to byte
+ */
+template <typename StreamT>
+void WriteIndex(BitsOStream<StreamT> &stream, const std::vector<IndexEntry> &index) {
+    uint64_t index_offset = stream.WrittenBits() / 8;
+    for (const auto &entry : index) {
+        stream.Write(entry.name.size(), 16);
+        stream.WriteBits(entry.name, 8 * entry.name.size());
+        stream.Write(entry.offset, 64);
+        stream.Write(entry.original_size, 64);
+        stream.Write(entry.compressed_size, 64);
+    }
+    stream.Write(index_offset, 64);
+    stream.Write(index.size(), 32);
+    stream.WriteBits(INDEX_MAGIC, 8 * INDEX_MAGIC.size());
+}
+
+namespace index_detail {
+
+struct Footer {
+    uint64_t index_offset;
+    uint64_t count;
+};
+
+/**
+ * @return footer or nothing if `footer` bytes are not a footer of index
+ */
+inline std::optional<Footer> ParseFooter(std::span<const char> footer, uint64_t archive_size) {
+    if (!std::equal(INDEX_MAGIC.begin(), INDEX_MAGIC.end(), footer.end() - INDEX_MAGIC.size())) {
+        return std::nullopt;
+    }
+    SpanByteSource source(footer);
+    ByteReader reader(source);
+    Footer result;
+    result.index_offset = reader.ReadUint(8);
+    result.count = reader.ReadUint(4);
+    if (result.index_offset < ARCHIVE_MAGIC.size() || result.index_offset > archive_size - INDEX_FOOTER_SIZE) {
+        throw std::runtime_error("Bad archive index");
+    }
+    return result;
+}
+
+/**
+ * @param entries bytes of index between its offset and footer
+ */
+inline std::vector<IndexEntry> ParseEntries(std::span<const char> entries, const Footer &footer) {
+    SpanByteSource source(entries);
+    ByteReader reader(source);
+    std::vector<IndexEntry> index;
+    for (uint64_t i = 0; i < footer.count; ++i) {
+        IndexEntry entry;
+        entry.name = ReadMemberName(reader);
+        entry.offset = reader.ReadUint(8);
+        entry.original_size = reader.ReadUint(8);
+        entry.compressed_size = reader.ReadUint(8);
+        if (entry.offset > footer.index_offset || entry.compressed_size > footer.index_offset - entry.offset) {
+            throw std::runtime_error("Bad archive index");
+        }
+        index.push_back(std::move(entry));
+    }
+    return index;
+}
+
+}  // namespace index_detail
+
+/**
+ * @return index of block format archive or nothing if the archive has no index
+ */
+inline std::optional<std::vector<IndexEntry>> ReadIndex(std::span<const char> archive) {
+    using namespace index_detail;
+    if (archive.size() < ARCHIVE_MAGIC.size() + INDEX_FOOTER_SIZE) {
+        return std::nullopt;
+    }
+    auto footer = ParseFooter(archive.last(INDEX_FOOTER_SIZE), archive.size());
+    if (!footer) {
+        return std::nullopt;
+    }
+    return ParseEntries(
+        archive.subspan(footer->index_offset, archive.size() - INDEX_FOOTER_SIZE - footer->index_offset), *footer);
+}
+
+/**
+ * @brief ReadIndex for seekable stream, which is left at unspecified position
+ */
+inline std::optional<std::vector<IndexEntry>> ReadIndex(std::istream &archive) {
+    using namespace index_detail;
+    archive.seekg(0, std::ios::end);
+    auto size = static_cast<uint64_t>(archive.tellg());
+    if (size < ARCHIVE_MAGIC.size() + INDEX_FOOTER_SIZE) {
+        return std::nullopt;
+    }
+    std::array<char, INDEX_FOOTER_SIZE> footer_bytes;
+    archive.seekg(static_cast<std::streamoff>(size - footer_bytes.size()));
+    archive.read(footer_bytes.data(), footer_bytes.size());
+    auto footer = ParseFooter(footer_bytes, size);
+    if (!footer) {
+        return std::nullopt;
+    }
+    std::vector<char> entries(size - INDEX_FOOTER_SIZE - footer->index_offset);
+    archive.seekg(static_cast<std::streamoff>(footer->index_offset));
+    archive.read(entries.data(), static_cast<std::streamsize>(entries.size()));
+    return ParseEntries(entries, *footer);
+}
+
+/**
+ * @brief Haffman table of block content with its encoder
+ */
+struct BlockTable {
+    explicit BlockTable(const SymbolsCounter &counter, size_t max_code_length)
+        : sorted_codes(BuildCodes(counter, max_code_length)), codes(sorted_codes) {
+    }
+
+    /**
+     * @return number of bits of content with `counter` encoded by this table, or max value if some symbol has no code
+     */
+    size_t EncodedSize(const SymbolsCounter &counter) const {
+        size_t size = 0;
+        for (size_t symbol = 0; symbol < counter.size(); ++symbol) {
+            if (counter[symbol] == 0) {
+                continue;
+            }
+            size_t length = codes.Length(static_cast<NineBits>(symbol));
+            if (length == 0) {
+                return std::numeric_limits<size_t>::max();
+            }
+            size += counter[symbol] * length;
+        }
+        return size;
+    }
+
+    StaticVector<std::pair<NineBits, Bits>, NINE_BITS_MAX + 1> sorted_codes;
+    EncodeTable codes;
+};
+
+/**
+ * @return number of bits of content with `counter` by its entropy, no Haffman table codes it shorter
+ */
+inline double EntropySize(const SymbolsCounter &counter) {
+    size_t total = 0;
+    for (size_t count : counter) {
+        total += count;
+    }
+    double size = 0;
+    for (size_t count : counter) {
+        if (count != 0) {
+            size += static_cast<double>(count) * std::log2(static_cast<double>(total) / static_cast<double>(count));
+        }
+    }
+    return size;
+}
+
+/**
+ * @return payload of a Haffman block, starting with the table if `write_table`
+ */
+inline std::vector<char> EncodeBlock(std::span<const char> data, const BlockTable &table, bool write_table) {
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    if (write_table) {
+        ArchiveCodes(table.sorted_codes, stream);
+    }
+    for (char c : data) {
+        stream << table.codes.At(CharToNineBits(c));
+    }
+    stream.Flush();
+    return std::move(sink.Bytes());
+}
+
+/**
+ * @brief decodes `size` bytes of a Haffman block to `out`, stream is positioned after the table
+ */
+template <typename StreamT>
+void DecodeBlock(BitsIStream<StreamT> &stream, const DecodeTable &table, char *out, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        // bytes decoded at once are not beyond the block, so its padding is not taken for codes
+        size_t count = size - i >= DecodeTable::MAX_MULTI_BYTES ? table.DecodeBytes(stream, out + i) : 0;
+        if (count != 0) {
+            i += count;
+            continue;
+        }
+        auto symbol = static_cast<uint16_t>(table.Decode(stream));
+        if (symbol >= 256) {
+            throw std::runtime_error("Enexpected control symbol");
+        }
+        out[i++] = static_cast<char>(symbol);
+    }
+}
+
+/**
+ * @return payload of an interleaved Haffman block, starting with the table if `write_table`
+ */
+inline std::vector<char> EncodeInterleavedBlock(std::span<const char> data, const BlockTable &table,
+                                                bool write_table) {
+    std::array<VectorByteSink, INTERLEAVED_STREAMS> sinks;
+    {
+        std::array<BitsOStream<VectorByteSink>, INTERLEAVED_STREAMS> streams = {
+            BitsOStream(sinks[0]), BitsOStream(sinks[1]), BitsOStream(sinks[2]), BitsOStream(sinks[3])};
+        for (size_t i = 0; i < data.size(); ++i) {
+            streams[i % INTERLEAVED_STREAMS] << table.codes.At(CharToNineBits(data[i]));
+        }
+        for (auto &stream : streams) {
+            stream.Flush();
+        }
+    }
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    if (write_table) {
+        ArchiveCodes(table.sorted_codes, stream);
+        stream.Flush();
+    }
+    for (size_t i = 0; i + 1 < INTERLEAVED_STREAMS; ++i) {
+        stream.Write(sinks[i].Bytes().size(), 32);
+    }
+    for (auto &stream_sink : sinks) {
+        stream.WriteBits(stream_sink.Bytes(), 8 * stream_sink.Bytes().size());
+    }
+    stream.Flush();
+    return std::move(sink.Bytes());
+}
+
+/**
+ * @brief decodes `size` bytes of an interleaved Haffman block to `out`
+ *
+ * @param streams payload after the table
+ */
+inline void DecodeInterleavedBlock(std::span<const char> streams, const DecodeTable &table, char *out, size_t size) {
+    constexpr size_t SIZES_SIZE = 4 * (INTERLEAVED_STREAMS - 1);
+    SpanByteSource sizes_source(streams);
+    ByteReader sizes_reader(sizes_source);
+    std::array<SpanByteSource, INTERLEAVED_STREAMS> sources = {SpanByteSource({}), SpanByteSource({}),
+                                                               SpanByteSource({}), SpanByteSource({})};
+    size_t offset = SIZES_SIZE;
+    for (size_t i = 0; i < INTERLEAVED_STREAMS; ++i) {
+        size_t stream_size = i + 1 < INTERLEAVED_STREAMS ? sizes_reader.ReadUint(4) : streams.size() - offset;
+        if (offset > streams.size() || stream_size > streams.size() - offset) {
+            throw std::runtime_error("Bad archive");
+        }
+        sources[i] = SpanByteSource(streams.subspan(offset, stream_size));
+        offset += stream_size;
+    }
+    std::array<BitsIStream<SpanByteSource>, INTERLEAVED_STREAMS> bits_streams = {
+        BitsIStream(sources[0]), BitsIStream(sources[1]), BitsIStream(sources[2]), BitsIStream(sources[3])};
+
+    size_t i = 0;
+    // symbols of different streams don't depend on each other, so their lookups overlap
+    for (; i + INTERLEAVED_STREAMS <= size; i += INTERLEAVED_STREAMS) {
+        auto first = static_cast<uint16_t>(table.Decode(bits_streams[0]));
+        auto second = static_cast<uint16_t>(table.Decode(bits_streams[1]));
+        auto third = static_cast<uint16_t>(table.Decode(bits_streams[2]));
+        auto fourth = static_cast<uint16_t>(table.Decode(bits_streams[3]));
+        if ((first | second | third | fourth) >= 256) {
+            throw std::runtime_error("Enexpected control symbol");
+        }
+        out[i] = static_cast<char>(first);
+        out[i + 1] = static_cast<char>(second);
+        out[i + 2] = static_cast<char>(third);
+        out[i + 3] = static_cast<char>(fourth);
+    }
+    for (; i < size; ++i) {
+        auto symbol = static_cast<uint16_t>(table.Decode(bits_streams[i % INTERLEAVED_STREAMS]));
+        if (symbol >= 256) {
+            throw std::runtime_error("Enexpected control symbol");
+        }
+        out[i] = static_cast<char>(symbol);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <ios>
+#include <vector>
+
+/**
+ * @brief Receiver of bytes written by arbitrary pieces
+ */
+template <class T>
+concept ByteSink = requires(T sink, const char *data, size_t size) {
+    sink.Write(data, size);
+    sink.Flush();
+};
+
+template <class OStreamT>
+class StreamByteSink {
+public:
+    explicit StreamByteSink(OStreamT &stream) : stream_(stream) {
+    }
+
+    void Write(const char *data, size_t size) {
+        stream_.write(data, static_cast<std::streamsize>(size));
+    }
+
+    void Flush() {
+        stream_.flush();
+    }
+
+private:
+    OStreamT &stream_;
+};
+
+/**
+ * @brief Collects bytes in memory
+ */
+class VectorByteSink {
+public:
+    void Write(const char *data, size_t size) {
+        bytes_.insert(bytes_.end(), data, data + size);
+    }
+
+    void Flush() {
+    }
+
+    std::vector<char> &Bytes() {
+        return bytes_;
+    }
+
+private:
+    std::vector<char> bytes_;
+};
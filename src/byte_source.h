@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <ios>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Source of bytes given by contiguous blocks, empty block means end of data
+ */
+template <class T>
+concept ByteSource = requires(T source) {
+    { source.NextBlock() } -> std::same_as<std::span<const char>>;
+};
+
+/**
+ * @brief ByteSource whose blocks stay valid while the source lives, so they can be referenced without copying;
+ * it gives all its bytes as a single block
+ */
+template <class T>
+concept StableByteSource = ByteSource<T> && T::STABLE_BLOCKS;
+
+/**
+ * @brief Gives bytes of memory owned by someone else as a single block
+ */
+class SpanByteSource {
+public:
+    static constexpr bool STABLE_BLOCKS = true;
+
+    explicit SpanByteSource(std::span<const char> data) : data_(data) {
+    }
+
+    std::span<const char> NextBlock() {
+        return std::exchange(data_, {});
+    }
+
+private:
+    std::span<const char> data_;
+};
+
+/**
+ * @brief Reads std::istream by blocks into its own buffer
+ */
+template <class IStreamT>
+class StreamByteSource {
+public:
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+    explicit StreamByteSource(IStreamT &stream, size_t block_size = BLOCK_SIZE) : stream_(stream), block_(block_size) {
+    }
+
+    std::span<const char> NextBlock() {
+        size_t size = 0;
+        while (size < block_.size()) {
+            auto read = stream_.rdbuf()->sgetn(block_.data() + size, static_cast<std::streamsize>(block_.size() - size));
+            if (read <= 0) {
+                break;
+            }
+            size += read;
+        }
+        return {block_.data(), size};
+    }
+
+private:
+    IStreamT &stream_;
+    std::vector<char> block_;
+};
+
+/**
+ * @brief Maps whole file into memory and gives it as a single block
+ *
+ * Only regular files of known size can be mapped, see CanMap; files of /proc report zero size and pipes have none.
+ */
+class MMapByteSource {
+public:
+    static constexpr bool STABLE_BLOCKS = true;
+
+    /**
+     * @brief whether `path` is a regular file with content size reported by stat, otherwise it is read as a stream;
+     * files that can't be stat'ed are taken as mappable, so the constructor reports the error
+     */
+    static bool CanMap(const std::filesystem::path &path) {
+        struct stat file_stat;
+        if (stat(path.c_str(), &file_stat) == -1) {
+            return true;
+        }
+        return S_ISREG(file_stat.st_mode) && file_stat.st_size > 0;
+    }
+
+    explicit MMapByteSource(const std::filesystem::path &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::system_error(errno, std::generic_category(), "Can't open " + path.string());
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == -1) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), "Can't stat " + path.string());
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ > 0) {
+            void *data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                int error = errno;
+                close(fd);
+                throw std::system_error(error, std::generic_category(), "Can't map " + path.string());
+            }
+            data_ = static_cast<const char *>(data);
+            madvise(data, size_, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    MMapByteSource(const MMapByteSource &) = delete;
+    MMapByteSource &operator=(const MMapByteSource &) = delete;
+
+    MMapByteSource(MMapByteSource &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), given_(other.given_) {
+    }
+
+    ~MMapByteSource() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    std::span<const char> NextBlock() {
+        if (given_) {
+            return {};
+        }
+        given_ = true;
+        return Data();
+    }
+
+    std::span<const char> Data() const {
+        return {data_, size_};
+    }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    bool given_ = false;
+};
+
+/**
+ * @brief Reads fixed-size fields and byte ranges from ByteSource, throws at unexpected end of data
+ */
+template <ByteSource SourceT>
+class ByteReader {
+public:
+    explicit ByteReader(SourceT &source) : source_(source) {
+    }
+
+    /**
+     * @return false if there are no bytes left
+     */
+    bool HasMore() {
+        return Available() > 0;
+    }
+
+    void Read(char *first, size_t size) {
+        while (size > 0) {
+            if (Available() == 0) {
+                throw std::runtime_error("Unexpected end of archive");
+            }
+            size_t part = std::min(size, block_.size());
+            std::memcpy(first, block_.data(), part);
+            block_ = block_.subspan(part);
+            first += part;
+            size -= part;
+        }
+    }
+
+    /**
+     * @brief reads big-endian unsigned integer of `bytes` bytes
+     */
+    uint64_t ReadUint(size_t bytes) {
+        char data[sizeof(uint64_t)];
+        Read(data, bytes);
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value = (value << 8) | static_cast<uint8_t>(data[i]);
+        }
+        return value;
+    }
+
+    /**
+     * @brief gives next `size` bytes, which are referenced in the source if it is stable or copied into `storage`
+     *
+     * `storage` grows only as bytes arrive, so a corrupted size can't force a huge allocation before the end of data
+     */
+    std::span<const char> Take(size_t size, std::vector<char> &storage) {
+        if constexpr (StableByteSource<SourceT>) {
+            if (Available() < size) {
+                throw std::runtime_error("Unexpected end of archive");
+            }
+            auto result = block_.first(size);
+            block_ = block_.subspan(size);
+            return result;
+        } else {
+            storage.clear();
+            while (storage.size() < size) {
+                if (Available() == 0) {
+                    throw std::runtime_error("Unexpected end of archive");
+                }
+                size_t part = std::min(size - storage.size(), block_.size());
+                storage.insert(storage.end(), block_.begin(), block_.begin() + part);
+                block_ = block_.subspan(part);
+            }
+            return storage;
+        }
+    }
+
+    void Skip(size_t size) {
+        while (size > 0) {
+            if (Available() == 0) {
+                throw std::runtime_error("Unexpected end of archive");
+            }
+            size_t part = std::min(size, block_.size());
+            block_ = block_.subspan(part);
+            size -= part;
+        }
+    }
+
+private:
+    size_t Available() {
+        if (block_.empty() && !source_end_) {
+            block_ = source_.NextBlock();
+            source_end_ = block_.empty();
+        }
+        return block_.size();
+    }
+
+    SourceT &source_;
+    std::span<const char> block_;
+    bool source_end_ = false;
+};
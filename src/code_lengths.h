@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "nine_bits.h"
+#include "priority_queue.h"
+#include "static_vector.h"
+#include "symbols_counter.h"
+#include "trie.h"
+
+/**
+ * @brief pairs (code length, symbol) for every symbol with nonzero count
+ */
+using CodeLengths = StaticVector<std::pair<size_t, NineBits>, NINE_BITS_MAX + 1>;
+
+/**
+ * @brief code lengths of Haffman tree, ties are broken by the smallest symbol in subtree
+ *
+ * Two-queue method over flat arrays: leaves sorted by (count, symbol) form the first queue, merged nodes
+ * appear in the second one already ordered by (count, smallest symbol), so no heap and no allocation is
+ * needed. Gives the same lengths as TrieHaffmanCodeLengths.
+ */
+inline CodeLengths HaffmanCodeLengths(const SymbolsCounter &counter) {
+    constexpr size_t MAX_SYMBOLS = NINE_BITS_MAX + 1;
+
+    struct Node {
+        size_t count;
+        uint16_t symbol;  // the smallest symbol in subtree
+        uint16_t parent;
+    };
+
+    std::array<Node, MAX_SYMBOLS> leaves;
+    size_t leaves_count = 0;
+    for (size_t i = 0; i < counter.size(); ++i) {
+        if (counter[i] != 0) {
+            leaves[leaves_count++] = {counter[i], static_cast<uint16_t>(i), 0};
+        }
+    }
+    CodeLengths codes_sizes;
+    if (leaves_count == 0) {
+        return codes_sizes;
+    }
+    std::sort(leaves.begin(), leaves.begin() + leaves_count, [](const Node &lhs, const Node &rhs) {
+        return lhs.count != rhs.count ? lhs.count < rhs.count : lhs.symbol < rhs.symbol;
+    });
+
+    // merged[i] is created by the i-th merge, its parent is always created later
+    std::array<Node, MAX_SYMBOLS> merged;
+    size_t merged_count = 0;
+    size_t next_leaf = 0;
+    size_t next_merged = 0;
+    auto take_smallest = [&]() -> Node & {
+        if (next_merged == merged_count) {
+            return leaves[next_leaf++];
+        }
+        if (next_leaf == leaves_count) {
+            return merged[next_merged++];
+        }
+        const Node &leaf = leaves[next_leaf];
+        const Node &node = merged[next_merged];
+        bool leaf_first = leaf.count != node.count ? leaf.count < node.count : leaf.symbol < node.symbol;
+        return leaf_first ? leaves[next_leaf++] : merged[next_merged++];
+    };
+    while (merged_count + 1 < leaves_count) {
+        Node &first = take_smallest();
+        Node &second = take_smallest();
+        first.parent = second.parent = static_cast<uint16_t>(merged_count);
+        merged[merged_count++] = {first.count + second.count, std::min(first.symbol, second.symbol), 0};
+    }
+
+    // depths of merged nodes, the root is the last one
+    std::array<size_t, MAX_SYMBOLS> depths;
+    if (merged_count > 0) {
+        depths[merged_count - 1] = 0;
+        for (size_t i = merged_count - 1; i-- > 0;) {
+            depths[i] = depths[merged[i].parent] + 1;
+        }
+    }
+    for (size_t i = 0; i < leaves_count; ++i) {
+        size_t depth = merged_count > 0 ? depths[leaves[i].parent] + 1 : 0;
+        codes_sizes.push_back({depth, static_cast<NineBits>(leaves[i].symbol)});
+    }
+    return codes_sizes;
+}
+
+/**
+ * @brief code lengths of Haffman tree built as trie through PriorityQueue, reference for HaffmanCodeLengths
+ */
+inline CodeLengths TrieHaffmanCodeLengths(const SymbolsCounter &counter) {
+    using HaffmanTrie = FlatTrie<NineBits, 2, uint16_t>;
+    HaffmanTrie trie(2 * counter.size());
+
+    struct PQValue {
+        size_t count;
+        NineBits value;
+        HaffmanTrie::NodeIndex node;
+        auto operator<=>(const PQValue &other) const {
+            if (count == other.count) {
+                return value <=> other.value;
+            } else {
+                return count <=> other.count;
+            }
+        }
+    };
+
+    PriorityQueue<PQValue, std::greater<PQValue>> chars;
+    for (size_t i = 0; i < counter.size(); ++i) {
+        auto c = static_cast<NineBits>(i);
+        if (counter[i] == 0) {
+            continue;
+        }
+        chars.Push({counter[i], c, trie.AddNode(true, c)});
+    }
+    if (chars.Size() == 0) {
+        return {};
+    }
+    while (chars.Size() >= 2) {
+        auto pq_v0 = chars.TopPop();
+        auto pq_v1 = chars.TopPop();
+        NineBits min_c = std::min(pq_v0.value, pq_v1.value);
+        auto new_node = trie.AddNode(false, min_c);
+        trie.SetChildren(new_node, 0, pq_v0.node);
+        trie.SetChildren(new_node, 1, pq_v1.node);
+        chars.Push({pq_v0.count + pq_v1.count, min_c, new_node});
+    }
+
+    CodeLengths codes_sizes;
+    trie.WalkTrie(chars.TopPop().node, [&codes_sizes](const auto &way, NineBits symbol) {
+        codes_sizes.push_back({way.size(), symbol});
+    });
+    return codes_sizes;
+}
+
+/**
+ * @brief optimal code lengths not longer than `max_length`, found by package-merge algorithm
+ */
+inline CodeLengths PackageMergeCodeLengths(const SymbolsCounter &counter, size_t max_length) {
+    struct Item {
+        size_t weight;
+        NineBits symbol;
+        bool is_leaf;
+    };
+
+    std::vector<Item> leaves;
+    for (size_t i = 0; i < counter.size(); ++i) {
+        if (counter[i] != 0) {
+            leaves.push_back({counter[i], static_cast<NineBits>(i), true});
+        }
+    }
+    if (leaves.size() <= 1 || max_length >= 64 || (size_t{1} << max_length) < leaves.size()) {
+        if (leaves.size() > 1) {
+            throw std::invalid_argument("Can't limit code length");
+        }
+        return leaves.empty() ? CodeLengths{} : CodeLengths{{1, leaves[0].symbol}};
+    }
+    std::stable_sort(leaves.begin(), leaves.end(),
+                     [](const Item &lhs, const Item &rhs) { return lhs.weight < rhs.weight; });
+
+    // lists[i] holds leaves merged with packages of pairs from lists[i + 1]
+    std::vector<std::vector<Item>> lists(max_length);
+    lists.back() = leaves;
+    for (size_t level = max_length - 1; level-- > 0;) {
+        const auto &deeper = lists[level + 1];
+        auto &list = lists[level];
+        list.reserve(leaves.size() + deeper.size() / 2);
+        size_t leaf = 0;
+        size_t package = 0;
+        while (leaf < leaves.size() || package + 1 < deeper.size()) {
+            if (package + 1 < deeper.size()) {
+                size_t package_weight = deeper[package].weight + deeper[package + 1].weight;
+                if (leaf == leaves.size() || package_weight < leaves[leaf].weight) {
+                    list.push_back({package_weight, NineBits{0}, false});
+                    package += 2;
+                    continue;
+                }
+            }
+            list.push_back(leaves[leaf++]);
+        }
+    }
+
+    // chosen items form a prefix of every list, each chosen package chooses two items of the deeper list
+    std::vector<size_t> lengths(counter.size(), 0);
+    size_t chosen = 2 * leaves.size() - 2;
+    for (const auto &list : lists) {
+        size_t packages = 0;
+        for (size_t i = 0; i < chosen; ++i) {
+            if (list[i].is_leaf) {
+                ++lengths[static_cast<size_t>(list[i].symbol)];
+            } else {
+                ++packages;
+            }
+        }
+        chosen = 2 * packages;
+    }
+
+    CodeLengths codes_sizes;
+    for (const auto &leaf : leaves) {
+        codes_sizes.push_back({lengths[static_cast<size_t>(leaf.symbol)], leaf.symbol});
+    }
+    return codes_sizes;
+}
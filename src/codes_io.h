@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "bits_stream.h"
+#include "decode_table.h"
+#include "haffman_codes.h"
+#include "nine_bits.h"
+
+/**
+ * @brief symbols count ArchiveCodes never writes, as codes have at least one symbol; in Haffman stream format it
+ * stands instead of codes of a file that reuses codes of the previous file
+ */
+inline constexpr size_t PREVIOUS_CODES_MARK = 0;
+
+/**
+ * @brief writes canonical codes as symbols count, symbols in order of codes and numbers of codes of every length
+ */
+template <typename StreamT>
+void ArchiveCodes(const SortedHaffmanCodes &sorted_codes, BitsOStream<StreamT> &archive_stream) {
+    archive_stream << static_cast<NineBits>(sorted_codes.size());
+    std::vector<size_t> count_with_lengths;
+    for (const auto &[symbol, code] : sorted_codes) {
+        archive_stream << symbol;
+        while (count_with_lengths.size() < code.Size()) {
+            count_with_lengths.push_back(0);
+        }
+        ++count_with_lengths.back();
+    }
+    for (auto count : count_with_lengths) {
+        archive_stream << static_cast<NineBits>(count);
+    }
+}
+
+/**
+ * @brief number of bits ArchiveCodes writes
+ */
+inline size_t ArchivedCodesSize(const SortedHaffmanCodes &sorted_codes) {
+    size_t max_length = sorted_codes.empty() ? 0 : sorted_codes.back().second.Size();
+    return 9 * (1 + sorted_codes.size() + max_length);
+}
+
+/**
+ * @brief reads codes written by ArchiveCodes
+ */
+template <typename StreamT>
+DecodeTable ReadCode(BitsIStream<StreamT> &archive_stream) {
+    size_t symbols_count = archive_stream.Read(9);
+    std::vector<NineBits> symbols(symbols_count);
+    for (NineBits &symbol : symbols) {
+        symbol = static_cast<NineBits>(archive_stream.Read(9));
+    }
+
+    std::vector<size_t> count_with_lengths;
+    for (size_t read_count = 0; read_count != symbols_count;) {
+        size_t symbols_with_size = archive_stream.Read(9);
+        if (read_count + symbols_with_size > symbols_count) {
+            throw std::runtime_error("Bad archive");
+        }
+        count_with_lengths.push_back(symbols_with_size);
+        read_count += symbols_with_size;
+    }
+    return DecodeTable(symbols, count_with_lengths);
+}
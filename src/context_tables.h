@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "bits_stream.h"
+#include "blocks.h"
+#include "byte_sink.h"
+#include "codes_io.h"
+#include "decode_table.h"
+#include "nine_bits.h"
+#include "symbols_counter.h"
+
+/**
+ * @brief Haffman tables of block content by context, the previous byte of the block (zero for the first byte)
+ *
+ * A context gets its own table if it pays for itself against the order-0 table of the block, other contexts share
+ * the table of their joint counts. Payload of an order-1 block is a bit showing the shared table and the table,
+ * then for every context a bit showing its own table and the table, then codes of bytes by tables of their contexts.
+ */
+class ContextTables {
+public:
+    static constexpr size_t CONTEXTS = ORDER1_CONTEXTS;
+    static constexpr size_t BYTE_SYMBOLS = 256;
+
+    ContextTables(std::span<const char> data, size_t max_code_length) {
+        std::vector<SymbolsCounter> counters(CONTEXTS);
+        uint8_t previous = 0;
+        for (char c : data) {
+            ++counters[previous][CharToNineBits(c)];
+            previous = static_cast<uint8_t>(c);
+        }
+        SymbolsCounter all;
+        for (const auto &counter : counters) {
+            for (size_t symbol = 0; symbol < BYTE_SYMBOLS; ++symbol) {
+                all[symbol] += counter[symbol];
+            }
+        }
+        BlockTable order0(all, max_code_length);
+
+        SymbolsCounter shared;
+        archived_size_ = 1 + CONTEXTS;
+        for (size_t context = 0; context < CONTEXTS; ++context) {
+            if (IsEmpty(counters[context])) {
+                continue;
+            }
+            BlockTable own(counters[context], max_code_length);
+            size_t own_size = ArchivedCodesSize(own.sorted_codes) + own.EncodedSize(counters[context]);
+            if (own_size < order0.EncodedSize(counters[context])) {
+                has_own_table_[context] = true;
+                table_of_[context] = static_cast<uint16_t>(tables_.size());
+                archived_size_ += own_size;
+                tables_.push_back(std::move(own));
+            } else {
+                for (size_t symbol = 0; symbol < BYTE_SYMBOLS; ++symbol) {
+                    shared[symbol] += counters[context][symbol];
+                }
+            }
+        }
+        has_shared_table_ = !IsEmpty(shared);
+        if (has_shared_table_) {
+            tables_.emplace_back(shared, max_code_length);
+            archived_size_ += ArchivedCodesSize(tables_.back().sorted_codes) + tables_.back().EncodedSize(shared);
+            for (size_t context = 0; context < CONTEXTS; ++context) {
+                if (!has_own_table_[context]) {
+                    table_of_[context] = static_cast<uint16_t>(tables_.size() - 1);
+                }
+            }
+        }
+    }
+
+    /**
+     * @return number of bits of payload
+     */
+    size_t ArchivedSize() const {
+        return archived_size_;
+    }
+
+    /**
+     * @return payload of an order-1 block of `data`, which the tables are built for
+     */
+    std::vector<char> Encode(std::span<const char> data) const {
+        VectorByteSink sink;
+        BitsOStream stream(sink);
+        stream.Write(has_shared_table_, 1);
+        if (has_shared_table_) {
+            ArchiveCodes(tables_.back().sorted_codes, stream);
+        }
+        for (size_t context = 0; context < CONTEXTS; ++context) {
+            stream.Write(has_own_table_[context], 1);
+            if (has_own_table_[context]) {
+                ArchiveCodes(tables_[table_of_[context]].sorted_codes, stream);
+            }
+        }
+        uint8_t previous = 0;
+        for (char c : data) {
+            stream << tables_[table_of_[previous]].codes.At(CharToNineBits(c));
+            previous = static_cast<uint8_t>(c);
+        }
+        stream.Flush();
+        return std::move(sink.Bytes());
+    }
+
+private:
+    static bool IsEmpty(const SymbolsCounter &counter) {
+        for (size_t count : counter) {
+            if (count != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<BlockTable> tables_;
+    std::array<uint16_t, CONTEXTS> table_of_ = {};
+    std::array<bool, CONTEXTS> has_own_table_ = {};
+    bool has_shared_table_ = false;
+    size_t archived_size_ = 0;
+};
+
+/**
+ * @brief decodes `size` bytes of an order-1 block to `out`
+ */
+template <typename StreamT>
+void DecodeContextBlock(BitsIStream<StreamT> &stream, char *out, size_t size) {
+    // the first table is empty, it fails to decode contexts without tables
+    std::vector<DecodeTable> tables(1);
+    size_t shared_table = 0;
+    if (stream.Read(1)) {
+        shared_table = tables.size();
+        tables.push_back(ReadCode(stream));
+    }
+    std::array<const DecodeTable *, ContextTables::CONTEXTS> table_of;
+    std::array<size_t, ContextTables::CONTEXTS> table_index;
+    for (size_t context = 0; context < ContextTables::CONTEXTS; ++context) {
+        table_index[context] = shared_table;
+        if (stream.Read(1)) {
+            table_index[context] = tables.size();
+            tables.push_back(ReadCode(stream));
+        }
+    }
+    for (size_t context = 0; context < ContextTables::CONTEXTS; ++context) {
+        table_of[context] = &tables[table_index[context]];
+    }
+    uint8_t previous = 0;
+    for (size_t i = 0; i < size; ++i) {
+        auto symbol = static_cast<uint16_t>(table_of[previous]->Decode(stream));
+        if (symbol >= 256) {
+            throw std::runtime_error("Enexpected control symbol");
+        }
+        out[i] = static_cast<char>(symbol);
+        previous = static_cast<uint8_t>(symbol);
+    }
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "bits.h"
+#include "bits_stream.h"
+#include "nine_bits.h"
+
+/**
+ * @brief Decoder of canonical Haffman codes with multi-level lookup tables
+ *
+ * Root table is indexed by next ROOT_BITS bits of the stream. Its entry either holds decoded symbol and its
+ * code length or points to a subtable indexed by the following bits of longer codes.
+ *
+ * Bytes table is indexed by the same bits and holds all bytes whose codes fit them, up to MAX_MULTI_BYTES, so runs
+ * of short codes are decoded by one lookup.
+ */
+class DecodeTable {
+public:
+    static constexpr unsigned ROOT_BITS = 11;
+    static constexpr unsigned MAX_SUB_BITS = 7;
+    static constexpr size_t MAX_CODE_LENGTH = Bits::MAX_SIZE;
+    static constexpr size_t MAX_MULTI_BYTES = 4;
+
+    DecodeTable() : DecodeTable({}, {}) {
+    }
+
+    /**
+     * @param symbols symbols in order of their canonical codes
+     * @param count_with_lengths i-th element is number of symbols with code length i + 1
+     */
+    DecodeTable(const std::vector<NineBits> &symbols, const std::vector<size_t> &count_with_lengths) {
+        std::vector<CanonicalCode> codes;
+        codes.reserve(symbols.size());
+        Bits code;
+        for (size_t i = 0; i < count_with_lengths.size(); ++i) {
+            code <<= 1;
+            if (count_with_lengths[i] > 0 && i + 1 > MAX_CODE_LENGTH) {
+                throw std::runtime_error("Too long code");
+            }
+            for (size_t j = 0; j < count_with_lengths[i]; ++j) {
+                if (codes.size() == symbols.size() || code.Size() != i + 1) {
+                    throw std::runtime_error("Bad archive");
+                }
+                codes.push_back({symbols[codes.size()], code});
+                ++code;
+            }
+        }
+
+        unsigned max_length = codes.empty() ? 1 : static_cast<unsigned>(codes.back().code.Size());
+        root_bits_ = std::min(max_length, ROOT_BITS);
+        entries_.resize(size_t{1} << root_bits_);
+        Fill(0, root_bits_, 0, codes.begin(), codes.end());
+        FillBytes();
+    }
+
+    template <typename StreamT>
+    NineBits Decode(BitsIStream<StreamT> &stream) const {
+        const Entry *entry = &entries_[stream.Peek(root_bits_)];
+        while (entry->sub_bits != 0) {
+            stream.Consume(entry->length);
+            entry = &entries_[entry->value + stream.Peek(entry->sub_bits)];
+        }
+        if (entry->length == 0) {
+            throw std::runtime_error("Not find symbol");
+        }
+        stream.Consume(entry->length);
+        return static_cast<NineBits>(entry->value);
+    }
+
+    /**
+     * @brief decodes following symbols while they are bytes, as many as fit the next ROOT_BITS bits, up to
+     * MAX_MULTI_BYTES
+     *
+     * @param out must have room for MAX_MULTI_BYTES bytes, all of them may be overwritten
+     * @return number of decoded bytes, zero if the next symbol has a longer code or is not a byte, then it is left
+     * in the stream for Decode
+     */
+    template <typename StreamT>
+    size_t DecodeBytes(BitsIStream<StreamT> &stream, char *out) const {
+        const BytesEntry &entry = bytes_entries_[stream.Peek(root_bits_)];
+        stream.Consume(entry.length);
+        std::memcpy(out, entry.bytes.data(), MAX_MULTI_BYTES);
+        return entry.count;
+    }
+
+private:
+    struct CanonicalCode {
+        NineBits symbol;
+        Bits code;
+    };
+
+    /**
+     * @brief symbol with length of its code, or link to subtable if sub_bits != 0, or invalid if length == 0
+     */
+    struct Entry {
+        uint16_t value = 0;
+        uint8_t length = 0;
+        uint8_t sub_bits = 0;
+    };
+
+    /**
+     * @brief bytes decoded from the same bits as root table entry with their total code length
+     */
+    struct BytesEntry {
+        std::array<char, MAX_MULTI_BYTES> bytes = {};
+        uint8_t count = 0;
+        uint8_t length = 0;
+    };
+
+    static uint64_t LowMask(unsigned bits) {
+        return (uint64_t{1} << bits) - 1;
+    }
+
+    using CodesIt = std::vector<CanonicalCode>::const_iterator;
+
+    /**
+     * @brief fills table at `offset` indexed by `bits` bits following the first `prefix_length` bits of codes,
+     * which are common for all codes in [first; last)
+     */
+    void Fill(size_t offset, unsigned bits, unsigned prefix_length, CodesIt first, CodesIt last) {
+        while (first != last) {
+            unsigned rest = first->code.Size() - prefix_length;
+            if (rest <= bits) {
+                size_t index = (first->code.Value() & LowMask(rest)) << (bits - rest);
+                Entry entry{static_cast<uint16_t>(first->symbol), static_cast<uint8_t>(rest), 0};
+                std::fill_n(entries_.begin() + offset + index, size_t{1} << (bits - rest), entry);
+                ++first;
+                continue;
+            }
+            auto group_index = [prefix_length, bits](const CanonicalCode &code) {
+                return (code.code.Value() >> (code.code.Size() - prefix_length - bits)) & LowMask(bits);
+            };
+            size_t index = group_index(*first);
+            auto group_last = std::find_if(
+                first, last, [&group_index, index](const CanonicalCode &code) { return group_index(code) != index; });
+            unsigned sub_bits =
+                std::min(static_cast<unsigned>(std::prev(group_last)->code.Size()) - prefix_length - bits, MAX_SUB_BITS);
+            size_t sub_offset = entries_.size();
+            entries_.resize(sub_offset + (size_t{1} << sub_bits));
+            entries_[offset + index] = {static_cast<uint16_t>(sub_offset), static_cast<uint8_t>(bits),
+                                        static_cast<uint8_t>(sub_bits)};
+            Fill(sub_offset, sub_bits, prefix_length + bits, first, group_last);
+            first = group_last;
+        }
+    }
+
+    /**
+     * @brief decodes every value of root bits by root table entries while codes are of bytes and fit in these bits
+     */
+    void FillBytes() {
+        bytes_entries_.resize(size_t{1} << root_bits_);
+        for (size_t index = 0; index < bytes_entries_.size(); ++index) {
+            BytesEntry &bytes_entry = bytes_entries_[index];
+            while (bytes_entry.count < MAX_MULTI_BYTES) {
+                // bits after the decoded ones, shifted in zeros are not parts of any code taken here
+                const Entry &entry = entries_[(index << bytes_entry.length) & LowMask(root_bits_)];
+                if (entry.sub_bits != 0 || entry.length == 0 || entry.length > root_bits_ - bytes_entry.length ||
+                    entry.value >= 256) {
+                    break;
+                }
+                bytes_entry.bytes[bytes_entry.count++] = static_cast<char>(entry.value);
+                bytes_entry.length += entry.length;
+            }
+        }
+    }
+
+    std::vector<Entry> entries_;
+    std::vector<BytesEntry> bytes_entries_;
+    unsigned root_bits_;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+#include "bits.h"
+#include "code_lengths.h"
+#include "nine_bits.h"
+#include "static_vector.h"
+#include "symbols_counter.h"
+
+using SortedHaffmanCodes = const StaticVector<std::pair<NineBits, Bits>, NINE_BITS_MAX + 1>;
+
+inline constexpr size_t DEFAULT_MAX_CODE_LENGTH = 15;
+// enough for codes of all 9-bit symbols
+inline constexpr size_t MIN_MAX_CODE_LENGTH = 9;
+
+/**
+ * @brief build canonical Haffman codes
+ *
+ * @param max_code_length if Haffman tree is deeper, code lengths are rebuilt by package-merge
+ */
+inline SortedHaffmanCodes BuildCodes(const SymbolsCounter &counter, size_t max_code_length = Bits::MAX_SIZE) {
+    CodeLengths codes_sizes = HaffmanCodeLengths(counter);
+    if (codes_sizes.empty()) {
+        return {};
+    }
+    if (codes_sizes.size() == 1) {
+        // a lone symbol still needs a nonempty code to be decoded
+        codes_sizes[0].first = 1;
+    }
+    auto longest = std::max_element(codes_sizes.begin(), codes_sizes.end());
+    if (longest->first > max_code_length) {
+        codes_sizes = PackageMergeCodeLengths(counter, max_code_length);
+    }
+    std::sort(codes_sizes.begin(), codes_sizes.end());
+    if (codes_sizes.back().first > Bits::MAX_SIZE) {
+        throw std::runtime_error("Too long code");
+    }
+
+    StaticVector<std::pair<NineBits, Bits>, NINE_BITS_MAX + 1> codes;
+    auto code = Bits() << codes_sizes[0].first;
+    codes.emplace_back(codes_sizes[0].second, code);
+    for (size_t i = 1; i < codes_sizes.size(); ++i) {
+        code = (++code) << static_cast<size_t>(codes_sizes[i].first - codes_sizes[i - 1].first);
+        codes.emplace_back(codes_sizes[i].second, code);
+    }
+    return codes;
+}
+
+/**
+ * @brief Haffman codes indexed directly by symbol
+ */
+class EncodeTable {
+public:
+    explicit EncodeTable(const SortedHaffmanCodes &sorted_codes) {
+        for (const auto &[symbol, code] : sorted_codes) {
+            codes_[static_cast<size_t>(symbol)] = code;
+        }
+    }
+
+    /**
+     * @brief code of a symbol the codes are built for
+     */
+    const Bits &operator[](NineBits symbol) const {
+        assert(codes_[static_cast<size_t>(symbol)].Size() != 0);
+        return codes_[static_cast<size_t>(symbol)];
+    }
+
+    /**
+     * @brief code of a symbol of content, which may have changed since the codes were built for it
+     */
+    const Bits &At(NineBits symbol) const {
+        const Bits &code = codes_[static_cast<size_t>(symbol)];
+        if (code.Size() == 0) {
+            throw std::runtime_error("Content changed while archiving");
+        }
+        return code;
+    }
+
+    /**
+     * @return length of the code of `symbol`, zero if it has no code
+     */
+    size_t Length(NineBits symbol) const {
+        return codes_[static_cast<size_t>(symbol)].Size();
+    }
+
+private:
+    std::array<Bits, NINE_BITS_MAX + 1> codes_;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+#include "symbols_counter.h"
+#include "thread_pool.h"
+
+namespace histogram_detail {
+
+inline constexpr size_t SUB_TABLES = 4;
+// keeps every 32-bit counter of a sub-table below 2^32
+inline constexpr size_t MAX_SLICE = size_t{1} << 30;
+
+using SubTables = std::array<std::array<uint32_t, 256>, SUB_TABLES>;
+
+/**
+ * @brief spreads 8 bytes of `word` over sub-tables, so equal neighbouring bytes hit different counters
+ */
+inline void CountWord(uint64_t word, SubTables &tables) {
+    ++tables[0][word & 0xff];
+    ++tables[1][(word >> 8) & 0xff];
+    ++tables[2][(word >> 16) & 0xff];
+    ++tables[3][(word >> 24) & 0xff];
+    ++tables[0][(word >> 32) & 0xff];
+    ++tables[1][(word >> 40) & 0xff];
+    ++tables[2][(word >> 48) & 0xff];
+    ++tables[3][word >> 56];
+}
+
+inline void CountTail(const uint8_t *first, const uint8_t *last, SubTables &tables) {
+    for (; first != last; ++first) {
+        ++tables[0][*first];
+    }
+}
+
+/**
+ * @brief 16 bytes per iteration through two 64-bit loads
+ */
+inline void CountWords(const uint8_t *first, const uint8_t *last, SubTables &tables) {
+    for (; last - first >= 16; first += 16) {
+        uint64_t low;
+        uint64_t high;
+        std::memcpy(&low, first, sizeof(low));
+        std::memcpy(&high, first + 8, sizeof(high));
+        CountWord(low, tables);
+        CountWord(high, tables);
+    }
+    CountTail(first, last, tables);
+}
+
+}  // namespace histogram_detail
+
+/**
+ * @brief adds counts of bytes of [first; last) to `counter`
+ */
+inline void CountBytes(const char *first, const char *last, SymbolsCounter &counter) {
+    using namespace histogram_detail;
+    auto begin = reinterpret_cast<const uint8_t *>(first);
+    auto end = reinterpret_cast<const uint8_t *>(last);
+    while (begin != end) {
+        const uint8_t *slice_end = end - begin > static_cast<ptrdiff_t>(MAX_SLICE) ? begin + MAX_SLICE : end;
+        SubTables tables = {};
+        CountWords(begin, slice_end, tables);
+        for (size_t byte = 0; byte < 256; ++byte) {
+            counter[byte] += size_t{tables[0][byte]} + tables[1][byte] + tables[2][byte] + tables[3][byte];
+        }
+        begin = slice_end;
+    }
+}
+
+/**
+ * @brief CountBytes splitting [first; last) between threads of `pool`, each counting its part into a private
+ * counter; parts are not smaller than `min_part`
+ */
+inline void ParallelCountBytes(const char *first, const char *last, SymbolsCounter &counter, ThreadPool &pool,
+                               size_t min_part = size_t{4} << 20) {
+    size_t size = last - first;
+    size_t parts = std::min(pool.Size(), size / std::max<size_t>(min_part, 1));
+    if (parts <= 1) {
+        CountBytes(first, last, counter);
+        return;
+    }
+    std::vector<std::future<SymbolsCounter>> part_counters;
+    part_counters.reserve(parts);
+    for (size_t i = 0; i < parts; ++i) {
+        const char *part_first = first + size * i / parts;
+        const char *part_last = first + size * (i + 1) / parts;
+        part_counters.push_back(pool.Submit([part_first, part_last] {
+            SymbolsCounter part_counter;
+            CountBytes(part_first, part_last, part_counter);
+            return part_counter;
+        }));
+    }
+    for (auto &part_counter : part_counters) {
+        auto part = part_counter.get();
+        for (size_t byte = 0; byte < 256; ++byte) {
+            counter[byte] += part[byte];
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @brief Vector with capacity fixed at compile time, stores elements inline without heap allocation
+ */
+template <typename T, size_t Capacity>
+class StaticVector {
+public:
+    StaticVector() = default;
+
+    StaticVector(std::initializer_list<T> values) {
+        for (const auto &value : values) {
+            push_back(value);
+        }
+    }
+
+    void push_back(T value) {  // NOLINT
+        if (size_ == Capacity) {
+            throw std::length_error("StaticVector is full");
+        }
+        data_[size_++] = std::move(value);
+    }
+
+    template <typename... Args>
+    T &emplace_back(Args &&...args) {  // NOLINT
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    void clear() {  // NOLINT
+        size_ = 0;
+    }
+
+    size_t size() const {  // NOLINT
+        return size_;
+    }
+
+    bool empty() const {  // NOLINT
+        return size_ == 0;
+    }
+
+    T &operator[](size_t i) {
+        return data_[i];
+    }
+
+    const T &operator[](size_t i) const {
+        return data_[i];
+    }
+
+    T &back() {  // NOLINT
+        return data_[size_ - 1];
+    }
+
+    const T &back() const {  // NOLINT
+        return data_[size_ - 1];
+    }
+
+    T *begin() {  // NOLINT
+        return data_.data();
+    }
+
+    T *end() {  // NOLINT
+        return data_.data() + size_;
+    }
+
+    const T *begin() const {  // NOLINT
+        return data_.data();
+    }
+
+    const T *end() const {  // NOLINT
+        return data_.data() + size_;
+    }
+
+private:
+    std::array<T, Capacity> data_;
+    size_t size_ = 0;
+};
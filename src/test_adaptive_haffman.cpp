@@ -0,0 +1,65 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "adaptive_haffman.h"
+#include "byte_source.h"
+
+static std::vector<char> Decode(const std::vector<char> &payload, size_t size) {
+    SpanByteSource source(payload);
+    BitsIStream stream(source);
+    std::vector<char> result(size);
+    DecodeAdaptiveBlock(stream, result.data(), result.size());
+    return result;
+}
+
+TEST_CASE("AdaptiveHaffman_Empty") {
+    REQUIRE(EncodeAdaptiveBlock({}).empty());
+}
+
+TEST_CASE("AdaptiveHaffman_OneSymbol") {
+    std::vector<char> data(1000, 'x');
+    auto payload = EncodeAdaptiveBlock(data);
+    // the first byte is raw, then codes of one bit
+    REQUIRE(payload.size() == (8 + 999 + 7) / 8);
+    REQUIRE(Decode(payload, data.size()) == data);
+}
+
+TEST_CASE("AdaptiveHaffman_AllBytes") {
+    std::vector<char> data;
+    for (size_t repeat = 0; repeat < 3; ++repeat) {
+        for (size_t byte = 0; byte < 256; ++byte) {
+            data.push_back(static_cast<char>(byte));
+        }
+    }
+    REQUIRE(Decode(EncodeAdaptiveBlock(data), data.size()) == data);
+}
+
+TEST_CASE("AdaptiveHaffman_Random") {
+    std::mt19937 gen(11);
+    for (double p : {0.9, 0.3, 0.05, 0.01}) {
+        std::geometric_distribution<int> distribution(p);
+        std::vector<char> data(200000);
+        for (char &c : data) {
+            c = static_cast<char>(distribution(gen));
+        }
+        auto payload = EncodeAdaptiveBlock(data);
+        REQUIRE(Decode(payload, data.size()) == data);
+        // shorter than fixed codes of 8 bits unless the distribution is close to uniform
+        if (p >= 0.05) {
+            REQUIRE(payload.size() < data.size());
+        }
+    }
+}
+
+TEST_CASE("AdaptiveHaffman_Truncated") {
+    std::vector<char> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * i % 7);
+    }
+    auto payload = EncodeAdaptiveBlock(data);
+    payload.resize(payload.size() / 2);
+    REQUIRE_THROWS(Decode(payload, data.size()));
+}
@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "archive.h"
+#include "unarchive.h"
+
+namespace fs = std::filesystem;
+
+static std::string ReadFile(const fs::path &path) {
+    std::ifstream stream(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * @brief Directory with archived files, removed at the end of test
+ */
+class TestDir {
+public:
+    TestDir() : path_(fs::temp_directory_path() / ("archiver_test_" + std::to_string(std::random_device()()))) {
+        fs::create_directories(path_ / "in");
+        std::mt19937 gen(5);
+        for (size_t file = 0; file < 6; ++file) {
+            std::string content(file * file * 3000, '\0');
+            for (char &c : content) {
+                c = static_cast<char>(file % 2 == 0 ? 'a' + gen() % (3 + file) : gen());
+            }
+            auto path = path_ / "in" / ("file" + std::to_string(file) + ".txt");
+            std::ofstream(path, std::ios::binary) << content;
+            files_.push_back(path);
+        }
+    }
+
+    ~TestDir() {
+        fs::current_path(fs::temp_directory_path());
+        fs::remove_all(path_);
+    }
+
+    const std::vector<fs::path> &Files() const {
+        return files_;
+    }
+
+    fs::path Path() const {
+        return path_;
+    }
+
+    /**
+     * @brief unarchives into a clean directory and checks that selected files are restored and others are not
+     */
+    void CheckUnarchive(const fs::path &archive, const UnarchiveOptions &options) const {
+        fs::remove_all(path_ / "out");
+        fs::create_directories(path_ / "out");
+        fs::current_path(path_ / "out");
+        Unarchive(archive, options);
+        for (const auto &file : files_) {
+            auto name = file.filename().string();
+            if (options.members.empty() || std::ranges::find(options.members, name) != options.members.end()) {
+                REQUIRE(ReadFile(path_ / "out" / name) == ReadFile(file));
+            } else {
+                REQUIRE(!fs::exists(path_ / "out" / name));
+            }
+        }
+    }
+
+private:
+    fs::path path_;
+    std::vector<fs::path> files_;
+};
+
+TEST_CASE("Archive_HaffmanStream") {
+    TestDir dir;
+    std::string first_archive;
+    for (size_t threads : {1, 3}) {
+        for (bool use_mmap : {true, false}) {
+            auto archive = dir.Path() / "archive";
+            Archive(dir.Files(), archive, {.use_mmap = use_mmap, .in_memory_limit = 20000, .threads = threads});
+            if (first_archive.empty()) {
+                first_archive = ReadFile(archive);
+            }
+            REQUIRE(ReadFile(archive) == first_archive);
+            dir.CheckUnarchive(archive, {.use_mmap = use_mmap});
+        }
+    }
+}
+
+TEST_CASE("Archive_Blocks") {
+    TestDir dir;
+    for (size_t block_size : {1, 1000, 100000}) {
+        std::string first_archive;
+        for (size_t threads : {1, 4}) {
+            auto archive = dir.Path() / "archive";
+            Archive(dir.Files(), archive, {.format = ArchiveFormat::BLOCKS, .block_size = block_size, .threads = threads});
+            if (first_archive.empty()) {
+                first_archive = ReadFile(archive);
+            }
+            REQUIRE(ReadFile(archive) == first_archive);
+            dir.CheckUnarchive(archive, {.use_mmap = threads == 1, .threads = threads});
+        }
+    }
+}
+
+TEST_CASE("Archive_Adaptive") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (size_t threads : {1, 3}) {
+        Archive(dir.Files(), archive,
+                {.format = ArchiveFormat::BLOCKS, .block_size = 7000, .adaptive = true, .threads = threads});
+        dir.CheckUnarchive(archive, {.threads = threads});
+    }
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.adaptive = true}));
+}
+
+TEST_CASE("Archive_Order1") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (size_t threads : {1, 3}) {
+        Archive(dir.Files(), archive,
+                {.format = ArchiveFormat::BLOCKS, .block_size = 7000, .order1 = true, .threads = threads});
+        dir.CheckUnarchive(archive, {.threads = threads});
+    }
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.order1 = true}));
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.format = ArchiveFormat::BLOCKS, .adaptive = true, .order1 = true}));
+}
+
+TEST_CASE("Archive_Interleaved") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (size_t threads : {1, 3}) {
+        Archive(dir.Files(), archive,
+                {.format = ArchiveFormat::BLOCKS, .block_size = 7000, .interleaved = true, .threads = threads});
+        dir.CheckUnarchive(archive, {.use_mmap = threads == 1, .threads = threads});
+    }
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.interleaved = true}));
+}
+
+/**
+ * @return size of a member of block format whose blocks are all stored
+ */
+static uint64_t StoredMemberSize(const ArchiveMember &member, size_t block_size) {
+    uint64_t blocks = (member.original_size + block_size - 1) / block_size;
+    return 1 + 2 + member.name.size() + (blocks + 1) * BLOCK_HEADER_SIZE + member.original_size;
+}
+
+TEST_CASE("Archive_InterleavedNotLarger") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    auto file = dir.Path() / "barely.bin";
+    // random bytes with more and more repeats of one byte, some of them are coded a few bytes shorter than they are
+    std::mt19937 gen(11);
+    std::string random(4000, '\0');
+    for (char &c : random) {
+        c = static_cast<char>(gen());
+    }
+    for (size_t repeats = 600; repeats < 660; ++repeats) {
+        std::ofstream(file, std::ios::binary) << random + std::string(repeats, 'a');
+        Archive({file}, archive, {.format = ArchiveFormat::BLOCKS, .block_size = 8000, .interleaved = true});
+        auto members = ListArchive(archive, {});
+        REQUIRE(members.size() == 1);
+        REQUIRE(members[0].archived_size <= StoredMemberSize(members[0], 8000));
+    }
+}
+
+TEST_CASE("Archive_Index") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (size_t threads : {1, 2}) {
+        Archive(dir.Files(), archive,
+                {.format = ArchiveFormat::BLOCKS, .block_size = 5000, .write_index = true, .threads = threads});
+        std::ifstream archive_stream(archive, std::ios::binary);
+        auto index = ReadIndex(archive_stream);
+        REQUIRE(index);
+        REQUIRE(index->size() == dir.Files().size());
+        std::string content = ReadFile(archive);
+        uint64_t offset = ARCHIVE_MAGIC.size();
+        for (size_t i = 0; i < index->size(); ++i) {
+            const auto &entry = (*index)[i];
+            REQUIRE(entry.name == dir.Files()[i].filename());
+            REQUIRE(entry.original_size == fs::file_size(dir.Files()[i]));
+            REQUIRE(entry.offset == offset);
+            REQUIRE(static_cast<MemberTag>(content[offset]) == MemberTag::MEMBER);
+            offset += entry.compressed_size;
+        }
+        REQUIRE(static_cast<MemberTag>(content[offset]) == MemberTag::ARCHIVE_END);
+        dir.CheckUnarchive(archive, {});
+    }
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.write_index = true}));
+}
+
+TEST_CASE("Archive_SelectMembers") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    std::vector<std::string> members = {"file4.txt", "file1.txt"};
+    for (ArchiveOptions options : {ArchiveOptions{},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000,
+                                                  .write_index = true}}) {
+        Archive(dir.Files(), archive, options);
+        for (bool use_mmap : {true, false}) {
+            dir.CheckUnarchive(archive, {.use_mmap = use_mmap, .threads = 2, .members = members});
+            REQUIRE_THROWS(dir.CheckUnarchive(archive, {.use_mmap = use_mmap, .members = {"file1.txt", "none"}}));
+        }
+    }
+}
+
+TEST_CASE("Archive_List") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (ArchiveOptions options : {ArchiveOptions{},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000,
+                                                  .write_index = true}}) {
+        Archive(dir.Files(), archive, options);
+        for (bool use_mmap : {true, false}) {
+            auto members = ListArchive(archive, {.use_mmap = use_mmap});
+            REQUIRE(members.size() == dir.Files().size());
+            uint64_t archived_size = options.format == ArchiveFormat::BLOCKS ? ARCHIVE_MAGIC.size() + 1 : 0;
+            for (size_t i = 0; i < members.size(); ++i) {
+                REQUIRE(members[i].name == dir.Files()[i].filename());
+                REQUIRE(members[i].original_size == fs::file_size(dir.Files()[i]));
+                archived_size += members[i].archived_size;
+            }
+            if (options.format == ArchiveFormat::BLOCKS && !options.write_index) {
+                REQUIRE(archived_size == fs::file_size(archive));
+            } else if (options.format == ArchiveFormat::HAFFMAN_STREAM) {
+                // every file but the last one may share a byte with the next one
+                REQUIRE(archived_size >= fs::file_size(archive));
+                REQUIRE(archived_size < fs::file_size(archive) + members.size());
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stream buffer of a pipe, which gives `content` and can't seek
+ */
+class PipeBuffer : public std::streambuf {
+public:
+    explicit PipeBuffer(std::string content) : content_(std::move(content)) {
+        setg(content_.data(), content_.data(), content_.data() + content_.size());
+    }
+
+private:
+    std::string content_;
+};
+
+TEST_CASE("Archive_ListPipe") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (ArchiveOptions options : {ArchiveOptions{},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000},
+                                   ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000,
+                                                  .write_index = true}}) {
+        Archive(dir.Files(), archive, options);
+        PipeBuffer pipe_buffer(ReadFile(archive));
+        std::istream pipe_stream(&pipe_buffer);
+        REQUIRE(pipe_stream.tellg() == -1);
+        auto members = ListArchive(pipe_stream);
+        REQUIRE(members.size() == dir.Files().size());
+        for (size_t i = 0; i < members.size(); ++i) {
+            REQUIRE(members[i].name == dir.Files()[i].filename());
+            REQUIRE(members[i].original_size == fs::file_size(dir.Files()[i]));
+        }
+    }
+}
+
+TEST_CASE("Archive_Stream") {
+    TestDir dir;
+    const auto &file = dir.Files().back();
+    for (bool write_index : {false, true}) {
+        ArchiveOptions options{.block_size = 4000, .write_index = write_index, .threads = 2};
+        std::istringstream content(ReadFile(file));
+        std::ostringstream archive_stream;
+        ArchiveStream(content, file.filename(), archive_stream, options);
+
+        auto archive = dir.Path() / "archive";
+        options.format = ArchiveFormat::BLOCKS;
+        Archive({file}, archive, options);
+        REQUIRE(archive_stream.str() == ReadFile(archive));
+    }
+}
+
+/**
+ * @brief Collects extracted files in memory
+ */
+class MemorySink : public UnarchiveSink {
+public:
+    void BeginFile(const std::string &name) override {
+        REQUIRE(!in_file_);
+        in_file_ = true;
+        files.emplace_back(name, "");
+    }
+
+    void Write(const char *data, size_t size) override {
+        REQUIRE(in_file_);
+        files.back().second.append(data, size);
+    }
+
+    void EndFile() override {
+        REQUIRE(in_file_);
+        in_file_ = false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> files;
+
+private:
+    bool in_file_ = false;
+};
+
+/**
+ * @brief Stream buffer of a full device, every write fails
+ */
+class FullBuffer : public std::streambuf {
+protected:
+    int_type overflow(int_type) override {
+        return traits_type::eof();
+    }
+};
+
+TEST_CASE("Archive_UnarchiveToSink") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (ArchiveOptions options :
+         {ArchiveOptions{}, ArchiveOptions{.format = ArchiveFormat::BLOCKS, .block_size = 5000}}) {
+        Archive(dir.Files(), archive, options);
+        for (bool use_mmap : {true, false}) {
+            MemorySink sink;
+            Unarchive(archive, sink, {.use_mmap = use_mmap, .threads = 2});
+            REQUIRE(sink.files.size() == dir.Files().size());
+            for (size_t i = 0; i < sink.files.size(); ++i) {
+                REQUIRE(sink.files[i].first == dir.Files()[i].filename());
+                REQUIRE(sink.files[i].second == ReadFile(dir.Files()[i]));
+            }
+
+            std::ostringstream stream;
+            StreamUnarchiveSink stream_sink(stream);
+            Unarchive(archive, stream_sink, {.use_mmap = use_mmap, .members = {"file3.txt", "file5.txt"}});
+            REQUIRE(stream.str() == ReadFile(dir.Files()[3]) + ReadFile(dir.Files()[5]));
+
+            FullBuffer full_buffer;
+            std::ostream full_stream(&full_buffer);
+            StreamUnarchiveSink full_sink(full_stream);
+            REQUIRE_THROWS(Unarchive(archive, full_sink, {.use_mmap = use_mmap}));
+        }
+    }
+}
+
+TEST_CASE("Archive_Stored") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    for (bool adaptive : {false, true}) {
+        Archive(dir.Files(), archive, {.format = ArchiveFormat::BLOCKS, .block_size = 5000, .adaptive = adaptive});
+        auto members = ListArchive(archive, {});
+        for (size_t i = 0; i < members.size(); ++i) {
+            // odd files are random bytes
+            if (i % 2 == 1) {
+                REQUIRE(members[i].archived_size == StoredMemberSize(members[i], 5000));
+            } else if (members[i].original_size != 0) {
+                REQUIRE(members[i].archived_size < members[i].original_size);
+            }
+        }
+        dir.CheckUnarchive(archive, {});
+    }
+
+    // signatures of compressed formats don't make compressible content stored
+    auto packed = dir.Path() / "packed.gz";
+    std::ofstream(packed, std::ios::binary) << std::string("\x1F\x8B") + std::string(12000, 'a');
+    auto random_packed = dir.Path() / "random.gz";
+    std::ofstream(random_packed, std::ios::binary) << std::string("\x1F\x8B") + ReadFile(dir.Files()[1]);
+    for (bool adaptive : {false, true}) {
+        for (bool store_compressed : {false, true}) {
+            Archive({packed, random_packed}, archive,
+                    {.format = ArchiveFormat::BLOCKS, .block_size = 5000, .adaptive = adaptive,
+                     .store_compressed = store_compressed});
+            auto members = ListArchive(archive, {});
+            REQUIRE(members.size() == 2);
+            REQUIRE(members[0].archived_size < members[0].original_size);
+            REQUIRE(members[1].archived_size == StoredMemberSize(members[1], 5000));
+            MemorySink sink;
+            Unarchive(archive, sink, {.use_mmap = false});
+            REQUIRE(sink.files.size() == 2);
+            REQUIRE(sink.files[0].second == ReadFile(packed));
+            REQUIRE(sink.files[1].second == ReadFile(random_packed));
+        }
+    }
+    REQUIRE_THROWS(Archive(dir.Files(), archive, {.store_compressed = true}));
+}
+
+TEST_CASE("Archive_ReuseTables") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    auto reused_archive = dir.Path() / "reused_archive";
+    // shards with the same distribution of bytes, where codes of the previous one fit well; names of files are coded
+    // by the same codes in Haffman stream format, so their bytes occur in content too
+    std::string alphabet = "shard.log0123456789 ebcfijkmnpqtuvwxyz";
+    std::vector<fs::path> shards;
+    std::mt19937 gen(7);
+    for (size_t shard = 0; shard < 5; ++shard) {
+        std::string content(2000, '\0');
+        for (char &c : content) {
+            c = alphabet[std::min(gen() % alphabet.size(), gen() % alphabet.size())];
+        }
+        shards.push_back(dir.Path() / ("shard" + std::to_string(shard) + ".log"));
+        std::ofstream(shards.back(), std::ios::binary) << content;
+    }
+    for (ArchiveOptions options : {ArchiveOptions{}, ArchiveOptions{.format = ArchiveFormat::BLOCKS}}) {
+        Archive(shards, archive, options);
+        options.reuse_tables = true;
+        Archive(shards, reused_archive, options);
+        REQUIRE(fs::file_size(reused_archive) < fs::file_size(archive));
+        options.threads = 2;
+        Archive(shards, archive, options);
+        REQUIRE(ReadFile(archive) == ReadFile(reused_archive));
+
+        auto members = ListArchive(reused_archive, {});
+        REQUIRE(members.size() == shards.size());
+        for (bool use_mmap : {true, false}) {
+            MemorySink sink;
+            Unarchive(reused_archive, sink, {.use_mmap = use_mmap});
+            REQUIRE(sink.files.size() == shards.size());
+            for (size_t i = 0; i < shards.size(); ++i) {
+                REQUIRE(sink.files[i].first == shards[i].filename());
+                REQUIRE(sink.files[i].second == ReadFile(shards[i]));
+            }
+
+            // skipped members still give their tables to the next ones
+            MemorySink selected_sink;
+            Unarchive(reused_archive, selected_sink, {.use_mmap = use_mmap, .members = {"shard3.log"}});
+            REQUIRE(selected_sink.files.size() == 1);
+            REQUIRE(selected_sink.files[0].second == ReadFile(shards[3]));
+        }
+    }
+    REQUIRE_THROWS(
+        Archive(shards, archive, {.format = ArchiveFormat::BLOCKS, .reuse_tables = true, .write_index = true}));
+}
+
+TEST_CASE("Archive_UnsizedFile") {
+    // files of /proc report zero size but have content
+    fs::path file = "/proc/version";
+    if (!fs::exists(file)) {
+        return;
+    }
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    std::string content = ReadFile(file);
+    REQUIRE(!content.empty());
+    for (bool use_mmap : {true, false}) {
+        for (ArchiveOptions options : {ArchiveOptions{.use_mmap = use_mmap},
+                                       ArchiveOptions{.format = ArchiveFormat::BLOCKS, .use_mmap = use_mmap}}) {
+            // mmap falls back to reading the file as a stream
+            Archive({file}, archive, options);
+            MemorySink sink;
+            Unarchive(archive, sink, {});
+            REQUIRE(sink.files.size() == 1);
+            REQUIRE(sink.files[0].first == "version");
+            REQUIRE(sink.files[0].second == content);
+            REQUIRE(ListArchive(archive, {})[0].original_size == content.size());
+        }
+    }
+}
+
+TEST_CASE("Archive_BadInterleavedBlock") {
+    TestDir dir;
+    auto archive = dir.Path() / "archive";
+    SymbolsCounter counter;
+    counter[CharToNineBits('a')] = 100;
+    counter[CharToNineBits('b')] = 1;
+    BlockTable table(counter, DEFAULT_MAX_CODE_LENGTH);
+    // the table takes the whole payload, so there are no streams to decode
+    auto payload = EncodeBlock({}, table, true);
+    {
+        std::ofstream stream(archive, std::ios::binary);
+        BitsOStream archive_stream(stream);
+        archive_stream.WriteBits(ARCHIVE_MAGIC, 8 * ARCHIVE_MAGIC.size());
+        WriteMemberName(archive_stream, "file");
+        WriteBlockHeader(archive_stream, {BlockMethod::INTERLEAVED_HAFFMAN, 101, static_cast<uint32_t>(payload.size())});
+        archive_stream.WriteBits(payload, 8 * payload.size());
+        WriteBlockHeader(archive_stream, {BlockMethod::MEMBER_END, 0, 0});
+        archive_stream.Write(static_cast<uint8_t>(MemberTag::ARCHIVE_END), 8);
+        archive_stream.Flush();
+    }
+    MemorySink sink;
+    REQUIRE_THROWS(Unarchive(archive, sink, {}));
+}
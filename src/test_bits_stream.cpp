@@ -1,11 +1,27 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <catch.hpp>
 
 #include "bits_stream.h"
 #include "nine_bits.h"
 
+TEST_CASE("Bits_Operations") {
+    Bits code = Bits() << 2;
+    REQUIRE(code == Bits(0b00, 2));
+    REQUIRE(++code == Bits(0b01, 2));
+    REQUIRE((++code << 1) == Bits(0b100, 3));
+    REQUIRE(++code == Bits(0b11, 2));
+    REQUIRE(++code == Bits(0b100, 3));
+    REQUIRE(code[0] == Bit::ONE);
+    REQUIRE(code[2] == Bit::ZERO);
+    REQUIRE(sizeof(Bits) <= 16);
+}
+
 TEST_CASE("BitsOStream_OneBit") {
     std::ostringstream x;
     BitsOStream stream(x);
@@ -42,6 +58,7 @@ TEST_CASE("BitsOStream_OneNineBitsSevenBits") {
     std::ostringstream osstream;
     BitsOStream stream(osstream);
     stream << NineBits{0b110101111} << Bit{0} << Bit{0} << Bit{0} << Bit{1} << Bit{0} << Bit{1} << Bit{1};
+    stream.Flush();
     std::string expected;
     expected.push_back(static_cast<char>(0b11010111));
     expected.push_back(static_cast<char>(0b10001011));
@@ -49,6 +66,96 @@ TEST_CASE("BitsOStream_OneNineBitsSevenBits") {
     REQUIRE(osstream.str() == expected);
 }
 
+TEST_CASE("BitsOStream_WriteValue") {
+    std::ostringstream osstream;
+    BitsOStream stream(osstream);
+    stream.Write(0b101, 3).Write(0b11110, 5).Write(0x123456789abcdef0, 64).Write(1, 1);
+    stream.Flush();
+    std::string expected;
+    expected.push_back(static_cast<char>(0b10111110));
+    for (char c : {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0}) {
+        expected.push_back(c);
+    }
+    expected.push_back(static_cast<char>(0b10000000));
+    REQUIRE(osstream.str() == expected);
+}
+
+TEST_CASE("BitsOStream_WriteMatchesBitByBit") {
+    std::mt19937_64 gen(42);
+    std::ostringstream by_bits_stream;
+    std::ostringstream by_words_stream;
+    BitsOStream by_bits(by_bits_stream);
+    BitsOStream by_words(by_words_stream);
+    for (size_t i = 0; i < 100000; ++i) {
+        unsigned length = std::uniform_int_distribution<unsigned>(1, 64)(gen);
+        uint64_t value = gen() >> (64 - length);
+        by_words.Write(value, length);
+        for (unsigned j = length; j > 0; --j) {
+            by_bits << static_cast<Bit>((value >> (j - 1)) & 1);
+        }
+    }
+    by_bits.Flush();
+    by_words.Flush();
+    REQUIRE(by_bits_stream.str().size() > BitsOStream<std::ostringstream>::BLOCK_SIZE);
+    REQUIRE(by_bits_stream.str() == by_words_stream.str());
+}
+
+TEST_CASE("BitsOStream_WriteBitsConcatenates") {
+    std::mt19937_64 gen(13);
+    std::ostringstream whole_stream;
+    std::ostringstream joined_stream;
+    BitsOStream whole(whole_stream);
+    BitsOStream joined(joined_stream);
+    for (size_t part = 0; part < 50; ++part) {
+        VectorByteSink part_sink;
+        BitsOStream part_stream(part_sink);
+        size_t writes = gen() % 300;
+        for (size_t i = 0; i < writes; ++i) {
+            unsigned length = std::uniform_int_distribution<unsigned>(1, 64)(gen);
+            uint64_t value = gen() >> (64 - length);
+            whole.Write(value, length);
+            part_stream.Write(value, length);
+        }
+        size_t bits = part_stream.WrittenBits();
+        part_stream.Flush();
+        REQUIRE(part_sink.Bytes().size() == (bits + 7) / 8);
+        joined.WriteBits(part_sink.Bytes(), bits);
+        REQUIRE(joined.WrittenBits() == whole.WrittenBits());
+    }
+    whole.Flush();
+    joined.Flush();
+    REQUIRE(whole_stream.str() == joined_stream.str());
+}
+
+TEST_CASE("BitsOStream_WriteBitsAligned") {
+    std::string bytes(3 * BitsOStream<std::ostringstream>::BLOCK_SIZE + 13, '\0');
+    std::mt19937 gen(17);
+    for (char &c : bytes) {
+        c = static_cast<char>(gen());
+    }
+    for (size_t prefix : {0, 3, 8, 16 + 5}) {
+        for (size_t size : {size_t{7}, size_t{100}, bytes.size()}) {
+            std::ostringstream by_bytes_stream;
+            std::ostringstream joined_stream;
+            BitsOStream by_bytes(by_bytes_stream);
+            BitsOStream joined(joined_stream);
+            for (size_t i = 0; i < prefix; ++i) {
+                by_bytes.Write(i, 8);
+                joined.Write(i, 8);
+            }
+            for (size_t i = 0; i < size; ++i) {
+                by_bytes.Write(static_cast<uint8_t>(bytes[i]), 8);
+            }
+            joined.WriteBits(bytes, 8 * size);
+            joined.Write(1, 1);
+            by_bytes.Write(1, 1);
+            by_bytes.Flush();
+            joined.Flush();
+            REQUIRE(by_bytes_stream.str() == joined_stream.str());
+        }
+    }
+}
+
 TEST_CASE("BitsIStream_OneBit") {
     std::string content;
     content.push_back(static_cast<char>(0b10000000));
@@ -86,3 +193,87 @@ TEST_CASE("BitsIStream_NineBits") {
     stream >> nine_bits;
     REQUIRE(nine_bits == NineBits{0b110101111});
 }
+
+TEST_CASE("BitsIStream_PeekRead") {
+    std::string content;
+    content.push_back(static_cast<char>(0b11010111));
+    content.push_back(static_cast<char>(0b10000001));
+    std::istringstream isstream(content);
+    BitsIStream stream(isstream);
+
+    REQUIRE(stream.Peek(3) == 0b110);
+    REQUIRE(stream.Peek(12) == 0b110101111000);
+    REQUIRE(stream.Read(4) == 0b1101);
+    REQUIRE(stream.Read(11) == 0b01111000000);
+    REQUIRE(stream.Peek(8) == 0b10000000);
+    REQUIRE(stream.Read(1) == 1);
+    REQUIRE_THROWS(stream.Read(1));
+}
+
+TEST_CASE("BitsIStream_ReadMatchesWrite") {
+    std::mt19937_64 gen(7);
+    std::vector<std::pair<uint64_t, unsigned>> values;
+    std::stringstream sstream;
+    BitsOStream ostream(sstream);
+    for (size_t i = 0; i < 100000; ++i) {
+        unsigned length = std::uniform_int_distribution<unsigned>(1, BitsIStream<std::stringstream>::MAX_PEEK_BITS)(gen);
+        uint64_t value = gen() >> (64 - length);
+        ostream.Write(value, length);
+        values.emplace_back(value, length);
+    }
+    ostream.Flush();
+    REQUIRE(sstream.str().size() > StreamByteSource<std::stringstream>::BLOCK_SIZE);
+
+    BitsIStream istream(sstream);
+    size_t read_bits = 0;
+    for (auto [value, length] : values) {
+        REQUIRE(istream.Read(length) == value);
+        read_bits += length;
+        REQUIRE(istream.ReadBits() == read_bits);
+    }
+}
+
+TEST_CASE("BitsStream_MMap") {
+    auto path = std::filesystem::temp_directory_path() / "test_bits_stream_mmap";
+    std::mt19937_64 gen(3);
+    std::vector<std::pair<uint64_t, unsigned>> values;
+    size_t total_bits = 0;
+    for (size_t i = 0; i < 50000; ++i) {
+        unsigned length = std::uniform_int_distribution<unsigned>(1, 30)(gen);
+        values.emplace_back(gen() >> (64 - length), length);
+        total_bits += length;
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        BitsOStream ostream(file);
+        for (auto [value, length] : values) {
+            ostream.Write(value, length);
+        }
+        ostream.Flush();
+    }
+    REQUIRE(std::filesystem::file_size(path) == (total_bits + 7) / 8);
+    {
+        MMapByteSource source(path);
+        BitsIStream istream(source);
+        for (auto [value, length] : values) {
+            REQUIRE(istream.Read(length) == value);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("MMapByteSource_CanMap") {
+    auto path = std::filesystem::temp_directory_path() / "mmap_can_map_test";
+    std::ofstream(path, std::ios::binary) << "content";
+    REQUIRE(MMapByteSource::CanMap(path));
+    std::ofstream(path, std::ios::binary | std::ios::trunc);
+    REQUIRE(!MMapByteSource::CanMap(path));
+    std::filesystem::remove(path);
+    // errors are left to the constructor
+    REQUIRE(MMapByteSource::CanMap(path));
+    REQUIRE_THROWS(MMapByteSource(path));
+    REQUIRE(!MMapByteSource::CanMap(std::filesystem::temp_directory_path()));
+    if (std::filesystem::exists("/proc/version")) {
+        REQUIRE(!MMapByteSource::CanMap("/proc/version"));
+    }
+}
@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "blocks.h"
+#include "byte_source.h"
+#include "context_tables.h"
+#include "histogram.h"
+
+static std::vector<char> RandomText(size_t size, size_t alphabet, uint32_t seed) {
+    std::mt19937 gen(seed);
+    std::geometric_distribution<int> distribution(0.3);
+    std::vector<char> text(size);
+    for (char &c : text) {
+        c = static_cast<char>('a' + distribution(gen) % alphabet);
+    }
+    return text;
+}
+
+static SymbolsCounter Count(const std::vector<char> &data) {
+    SymbolsCounter counter;
+    CountBytes(data.data(), data.data() + data.size(), counter);
+    return counter;
+}
+
+static std::vector<char> Decode(const std::vector<char> &payload, size_t size, const DecodeTable *table = nullptr) {
+    SpanByteSource source(payload);
+    BitsIStream stream(source);
+    DecodeTable own_table;
+    if (table == nullptr) {
+        own_table = ReadCode(stream);
+        table = &own_table;
+    }
+    std::vector<char> result(size);
+    DecodeBlock(stream, *table, result.data(), result.size());
+    return result;
+}
+
+TEST_CASE("Blocks_EncodeDecode") {
+    for (size_t alphabet : {1, 2, 26}) {
+        auto data = RandomText(10000, alphabet, static_cast<uint32_t>(alphabet));
+        BlockTable table(Count(data), DEFAULT_MAX_CODE_LENGTH);
+        auto payload = EncodeBlock(data, table, true);
+        REQUIRE(8 * payload.size() == (ArchivedCodesSize(table.sorted_codes) + table.EncodedSize(Count(data)) + 7) / 8 * 8);
+        REQUIRE(Decode(payload, data.size()) == data);
+    }
+}
+
+TEST_CASE("Blocks_PreviousTable") {
+    auto first = RandomText(5000, 10, 1);
+    auto second = RandomText(5000, 10, 2);
+    BlockTable table(Count(first), DEFAULT_MAX_CODE_LENGTH);
+    REQUIRE(table.EncodedSize(Count(second)) != std::numeric_limits<size_t>::max());
+    auto first_payload = EncodeBlock(first, table, true);
+    auto second_payload = EncodeBlock(second, table, false);
+
+    SpanByteSource source(first_payload);
+    BitsIStream stream(source);
+    DecodeTable decode_table = ReadCode(stream);
+    REQUIRE(Decode(second_payload, second.size(), &decode_table) == second);
+
+    // symbols without codes can't be encoded with the table
+    second.push_back('z');
+    REQUIRE(table.EncodedSize(Count(second)) == std::numeric_limits<size_t>::max());
+}
+
+TEST_CASE("Blocks_Header") {
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    WriteMemberName(stream, "file.txt");
+    WriteBlockHeader(stream, {BlockMethod::HAFFMAN, 100000, 70000});
+    WriteBlockHeader(stream, {BlockMethod::MEMBER_END, 0, 0});
+    stream.Flush();
+    REQUIRE(sink.Bytes().size() == 3 + 8 + 2 * BLOCK_HEADER_SIZE);
+
+    SpanByteSource source(sink.Bytes());
+    ByteReader reader(source);
+    REQUIRE(static_cast<MemberTag>(reader.ReadUint(1)) == MemberTag::MEMBER);
+    REQUIRE(ReadMemberName(reader) == "file.txt");
+    auto header = ReadBlockHeader(reader);
+    REQUIRE(header.method == BlockMethod::HAFFMAN);
+    REQUIRE(header.raw_size == 100000);
+    REQUIRE(header.payload_size == 70000);
+    REQUIRE(ReadBlockHeader(reader).method == BlockMethod::MEMBER_END);
+    REQUIRE_FALSE(reader.HasMore());
+    REQUIRE_THROWS(reader.ReadUint(1));
+}
+
+TEST_CASE("ByteReader_Take") {
+    std::string data(100000, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    std::vector<char> storage;
+
+    SpanByteSource span_source(data);
+    ByteReader span_reader(span_source);
+    span_reader.Skip(10);
+    auto taken = span_reader.Take(1000, storage);
+    REQUIRE(taken.data() == data.data() + 10);
+    REQUIRE(storage.empty());
+
+    std::istringstream stream(data);
+    StreamByteSource<std::istringstream> stream_source(stream, 4096);
+    ByteReader stream_reader(stream_source);
+    stream_reader.Skip(5000);
+    taken = stream_reader.Take(10000, storage);
+    REQUIRE(taken.data() == storage.data());
+    REQUIRE(std::string(taken.begin(), taken.end()) == data.substr(5000, 10000));
+    REQUIRE(stream_reader.ReadUint(2) == (uint8_t(15000 * 7) << 8 | uint8_t(15001 * 7)));
+    REQUIRE_THROWS(stream_reader.Skip(data.size()));
+}
+
+TEST_CASE("ByteReader_TakeTruncated") {
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    WriteBlockHeader(stream, {BlockMethod::HAFFMAN, 1 << 28, 2000000000});
+    for (size_t i = 0; i < 40; ++i) {
+        stream.Write(i, 8);
+    }
+    stream.Flush();
+    auto data = sink.Bytes();
+    std::vector<char> storage;
+
+    SpanByteSource span_source(data);
+    ByteReader span_reader(span_source);
+    auto header = ReadBlockHeader(span_reader);
+    REQUIRE_THROWS(span_reader.Take(header.payload_size, storage));
+    REQUIRE(storage.capacity() == 0);
+
+    std::istringstream input(std::string(data.begin(), data.end()));
+    StreamByteSource<std::istringstream> stream_source(input, 16);
+    ByteReader stream_reader(stream_source);
+    header = ReadBlockHeader(stream_reader);
+    REQUIRE_THROWS(stream_reader.Take(header.payload_size, storage));
+    REQUIRE(storage.capacity() < 1024);
+}
+
+TEST_CASE("Blocks_Index") {
+    std::vector<IndexEntry> index = {{"a.txt", 4, 100, 60}, {"b", 64, 0, 14}, {std::string(300, 'c'), 78, 1 << 30, 30}};
+    VectorByteSink sink;
+    BitsOStream stream(sink);
+    stream.WriteBits(ARCHIVE_MAGIC, 8 * ARCHIVE_MAGIC.size());
+    stream.Write(0, 64);
+    for (size_t i = 0; i < 100; ++i) {
+        stream.Write(i, 8);
+    }
+    stream.Write(static_cast<uint8_t>(MemberTag::ARCHIVE_END), 8);
+    auto without_index = sink.Bytes();
+    WriteIndex(stream, index);
+    stream.Flush();
+    const auto &archive = sink.Bytes();
+
+    REQUIRE(ReadIndex(archive) == index);
+    std::istringstream archive_stream(std::string(archive.begin(), archive.end()));
+    REQUIRE(ReadIndex(archive_stream) == index);
+    REQUIRE_FALSE(ReadIndex(without_index));
+    std::istringstream without_index_stream(std::string(without_index.begin(), without_index.end()));
+    REQUIRE_FALSE(ReadIndex(without_index_stream));
+
+    auto bad_offset = archive;
+    bad_offset[bad_offset.size() - INDEX_FOOTER_SIZE] = '\x7f';
+    REQUIRE_THROWS(ReadIndex(bad_offset));
+    auto bad_count = archive;
+    bad_count[bad_count.size() - INDEX_MAGIC.size() - 1] = '\x04';
+    REQUIRE_THROWS(ReadIndex(bad_count));
+}
+
+TEST_CASE("Blocks_Order1") {
+    // every byte mostly determines the next one
+    std::mt19937 gen(4);
+    std::vector<char> data(100000);
+    char previous = 'a';
+    for (char &c : data) {
+        c = gen() % 8 == 0 ? static_cast<char>('a' + gen() % 16) : static_cast<char>('a' + (previous * 5 + 3) % 16);
+        previous = c;
+    }
+    ContextTables tables(data, DEFAULT_MAX_CODE_LENGTH);
+    auto payload = tables.Encode(data);
+    REQUIRE(payload.size() == (tables.ArchivedSize() + 7) / 8);
+    BlockTable order0(Count(data), DEFAULT_MAX_CODE_LENGTH);
+    REQUIRE(tables.ArchivedSize() < order0.EncodedSize(Count(data)) / 2);
+
+    for (auto block : {std::span<const char>(data), std::span<const char>(data).first(1)}) {
+        ContextTables block_tables(block, DEFAULT_MAX_CODE_LENGTH);
+        auto block_payload = block_tables.Encode(block);
+        SpanByteSource source(block_payload);
+        BitsIStream stream(source);
+        std::vector<char> decoded(block.size());
+        DecodeContextBlock(stream, decoded.data(), decoded.size());
+        REQUIRE(std::equal(decoded.begin(), decoded.end(), block.begin(), block.end()));
+    }
+}
+
+TEST_CASE("Blocks_Interleaved") {
+    auto data = RandomText(10001, 20, 5);
+    BlockTable table(Count(data), DEFAULT_MAX_CODE_LENGTH);
+    auto table_payload = EncodeBlock({}, table, true);
+    SpanByteSource table_source(table_payload);
+    BitsIStream table_stream(table_source);
+    DecodeTable decode_table = ReadCode(table_stream);
+    for (size_t size : {0, 1, 3, 4, 5, 10001}) {
+        auto block = std::span<const char>(data).first(size);
+        for (bool write_table : {true, false}) {
+            auto payload = EncodeInterleavedBlock(block, table, write_table);
+            // sizes of streams and padding of every stream
+            REQUIRE(payload.size() <= EncodeBlock(block, table, write_table).size() + 4 * 3 + INTERLEAVED_STREAMS);
+
+            SpanByteSource source(payload);
+            BitsIStream stream(source);
+            size_t streams_offset = 0;
+            if (write_table) {
+                ReadCode(stream);
+                streams_offset = (stream.ReadBits() + 7) / 8;
+            }
+            std::vector<char> decoded(size);
+            DecodeInterleavedBlock(std::span<const char>(payload).subspan(streams_offset), decode_table,
+                                   decoded.data(), decoded.size());
+            REQUIRE(std::equal(decoded.begin(), decoded.end(), block.begin(), block.end()));
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include <array>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "bits_stream.h"
+#include "decode_table.h"
+#include "haffman_codes.h"
+#include "symbols_counter.h"
+
+static DecodeTable MakeDecodeTable(SortedHaffmanCodes &codes) {
+    std::vector<NineBits> symbols;
+    std::vector<size_t> count_with_lengths;
+    for (const auto &[symbol, code] : codes) {
+        symbols.push_back(symbol);
+        count_with_lengths.resize(code.Size(), 0);
+        ++count_with_lengths.back();
+    }
+    return DecodeTable(symbols, count_with_lengths);
+}
+
+static void CheckRoundTrip(const SymbolsCounter &counter, const std::vector<NineBits> &message) {
+    SortedHaffmanCodes sorted_codes = BuildCodes(counter);
+    EncodeTable codes(sorted_codes);
+
+    std::stringstream stream;
+    BitsOStream bits_ostream(stream);
+    for (NineBits symbol : message) {
+        bits_ostream << codes[symbol];
+    }
+    bits_ostream.Flush();
+
+    DecodeTable table = MakeDecodeTable(sorted_codes);
+    BitsIStream bits_istream(stream);
+    for (NineBits symbol : message) {
+        REQUIRE(table.Decode(bits_istream) == symbol);
+    }
+}
+
+TEST_CASE("DecodeTable_ShortCodes") {
+    SymbolsCounter counter;
+    std::vector<NineBits> message;
+    std::mt19937 gen(1);
+    for (size_t i = 0; i < 10000; ++i) {
+        auto symbol = static_cast<NineBits>(std::uniform_int_distribution<uint16_t>(0, 300)(gen));
+        ++counter[symbol];
+        message.push_back(symbol);
+    }
+    CheckRoundTrip(counter, message);
+}
+
+TEST_CASE("DecodeTable_LongCodes") {
+    SymbolsCounter counter;
+    size_t prev = 1;
+    size_t current = 1;
+    for (size_t i = 0; i < 40; ++i) {
+        counter[i] = current;
+        current += prev;
+        prev = current - prev;
+    }
+    std::vector<NineBits> message;
+    for (size_t i = 0; i < 40; ++i) {
+        message.push_back(static_cast<NineBits>(i));
+        message.push_back(static_cast<NineBits>(39 - i));
+    }
+    REQUIRE(BuildCodes(counter).back().second.Size() == 39);
+    CheckRoundTrip(counter, message);
+}
+
+TEST_CASE("DecodeTable_BadCodes") {
+    std::vector<NineBits> symbols = {NineBits{1}, NineBits{2}, NineBits{3}};
+    REQUIRE_THROWS(DecodeTable(symbols, {3}));
+
+    std::stringstream stream;
+    stream.put(0);
+    BitsIStream bits_istream(stream);
+    DecodeTable table(symbols, {0, 3});
+    REQUIRE(table.Decode(bits_istream) == NineBits{1});
+    REQUIRE(table.Decode(bits_istream) == NineBits{1});
+    REQUIRE(table.Decode(bits_istream) == NineBits{1});
+    REQUIRE(table.Decode(bits_istream) == NineBits{1});
+    REQUIRE_THROWS(table.Decode(bits_istream));
+}
+
+TEST_CASE("DecodeTable_DecodeBytes") {
+    SymbolsCounter counter;
+    std::vector<NineBits> message;
+    std::mt19937 gen(2);
+    std::geometric_distribution<uint16_t> distribution(0.5);
+    for (size_t i = 0; i < 100000; ++i) {
+        // rare symbols beyond bytes stop decoding of several bytes
+        auto symbol = static_cast<NineBits>(i % 1000 == 999 ? 256 + i % 3 : distribution(gen) % 256);
+        ++counter[symbol];
+        message.push_back(symbol);
+    }
+    SortedHaffmanCodes sorted_codes = BuildCodes(counter);
+    EncodeTable codes(sorted_codes);
+    std::stringstream stream;
+    BitsOStream bits_ostream(stream);
+    for (NineBits symbol : message) {
+        bits_ostream << codes[symbol];
+    }
+    bits_ostream.Flush();
+
+    DecodeTable table = MakeDecodeTable(sorted_codes);
+    BitsIStream bits_istream(stream);
+    std::vector<NineBits> decoded;
+    size_t multi_lookups = 0;
+    while (decoded.size() < message.size()) {
+        std::array<char, DecodeTable::MAX_MULTI_BYTES> bytes;
+        size_t count = message.size() - decoded.size() >= bytes.size() ? table.DecodeBytes(bits_istream, bytes.data()) : 0;
+        multi_lookups += count > 1;
+        for (size_t i = 0; i < count; ++i) {
+            decoded.push_back(static_cast<NineBits>(static_cast<uint8_t>(bytes[i])));
+        }
+        if (count == 0) {
+            decoded.push_back(table.Decode(bits_istream));
+        }
+    }
+    REQUIRE(decoded == message);
+    REQUIRE(multi_lookups > message.size() / 10);
+}
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "code_lengths.h"
+#include "haffman_codes.h"
+#include "symbols_counter.h"
+
+static SymbolsCounter FibonacciCounter(size_t symbols) {
+    SymbolsCounter counter;
+    size_t prev = 1;
+    size_t current = 1;
+    for (size_t i = 0; i < symbols; ++i) {
+        counter[i] = current;
+        current += prev;
+        prev = current - prev;
+    }
+    return counter;
+}
+
+static size_t Cost(const SymbolsCounter &counter, const CodeLengths &lengths) {
+    size_t cost = 0;
+    for (auto [length, symbol] : lengths) {
+        cost += length * counter[symbol];
+    }
+    return cost;
+}
+
+/**
+ * @brief checks that canonical codes are prefix-free and complete
+ */
+static void CheckCanonical(SortedHaffmanCodes &codes) {
+    long double kraft_sum = 0;
+    for (size_t i = 0; i < codes.size(); ++i) {
+        kraft_sum += 1.0L / static_cast<long double>(uint64_t{1} << codes[i].second.Size());
+        if (i > 0) {
+            const Bits &prev = codes[i - 1].second;
+            const Bits &current = codes[i].second;
+            REQUIRE(prev.Size() <= current.Size());
+            REQUIRE((prev.Value() << (current.Size() - prev.Size())) < current.Value());
+        }
+    }
+    REQUIRE(kraft_sum == 1.0L);
+}
+
+TEST_CASE("BuildCodes_Canonical") {
+    SymbolsCounter counter;
+    counter[NineBits{'a'}] = 5;
+    counter[NineBits{'b'}] = 2;
+    counter[NineBits{'c'}] = 1;
+    counter[NineBits{'d'}] = 1;
+    SortedHaffmanCodes codes = BuildCodes(counter);
+    std::vector<std::pair<NineBits, Bits>> expected = {
+        {NineBits{'a'}, Bits(0b0, 1)},
+        {NineBits{'b'}, Bits(0b10, 2)},
+        {NineBits{'c'}, Bits(0b110, 3)},
+        {NineBits{'d'}, Bits(0b111, 3)},
+    };
+    REQUIRE(std::vector(codes.begin(), codes.end()) == expected);
+}
+
+TEST_CASE("BuildCodes_SingleSymbol") {
+    SymbolsCounter counter;
+    counter[NineBits{'x'}] = 10;
+    SortedHaffmanCodes codes = BuildCodes(counter);
+    REQUIRE(codes.size() == 1);
+    REQUIRE(codes[0].second == Bits(0b0, 1));
+}
+
+TEST_CASE("HaffmanCodeLengths_MatchTrie") {
+    auto sorted = [](CodeLengths lengths) {
+        std::sort(lengths.begin(), lengths.end());
+        return std::vector(lengths.begin(), lengths.end());
+    };
+    std::mt19937 gen(7);
+    for (size_t test = 0; test < 100; ++test) {
+        SymbolsCounter counter;
+        size_t symbols = 1 + gen() % 259;
+        // few distinct counts give many ties
+        size_t max_count = test % 2 == 0 ? 4 : 100000;
+        for (size_t i = 0; i < symbols; ++i) {
+            counter[gen() % 259] = gen() % 4 == 0 ? 0 : 1 + gen() % max_count;
+        }
+        REQUIRE(sorted(HaffmanCodeLengths(counter)) == sorted(TrieHaffmanCodeLengths(counter)));
+    }
+    REQUIRE(HaffmanCodeLengths(SymbolsCounter{}).empty());
+    REQUIRE(sorted(HaffmanCodeLengths(FibonacciCounter(60))) == sorted(TrieHaffmanCodeLengths(FibonacciCounter(60))));
+}
+
+TEST_CASE("BuildCodes_LengthLimit") {
+    auto counter = FibonacciCounter(40);
+    REQUIRE(BuildCodes(counter).back().second.Size() == 39);
+    for (size_t limit : {9, 12, 15, 20, 38}) {
+        SortedHaffmanCodes codes = BuildCodes(counter, limit);
+        REQUIRE(codes.size() == 40);
+        REQUIRE(codes.back().second.Size() == limit);
+        CheckCanonical(codes);
+    }
+}
+
+TEST_CASE("PackageMerge_Optimal") {
+    std::mt19937 gen(11);
+    for (size_t test = 0; test < 20; ++test) {
+        SymbolsCounter counter;
+        for (size_t i = 0; i < 259; ++i) {
+            counter[i] = gen() % 3 == 0 ? 0 : 1 + (gen() % 1000) * (gen() % 1000);
+        }
+        auto haffman = HaffmanCodeLengths(counter);
+        size_t depth = std::max_element(haffman.begin(), haffman.end())->first;
+        // without real limit package-merge finds an optimal code, as Haffman does
+        REQUIRE(Cost(counter, PackageMergeCodeLengths(counter, depth)) == Cost(counter, haffman));
+        REQUIRE(Cost(counter, PackageMergeCodeLengths(counter, 9)) >= Cost(counter, haffman));
+    }
+    REQUIRE_THROWS(PackageMergeCodeLengths(FibonacciCounter(300), 8));
+}
+
+TEST_CASE("EncodeTable_MissingSymbol") {
+    SymbolsCounter counter;
+    counter['a'] = 3;
+    counter['b'] = 1;
+    EncodeTable codes(BuildCodes(counter));
+    REQUIRE(codes.At(static_cast<NineBits>('a')) == codes[static_cast<NineBits>('a')]);
+    REQUIRE(codes.Length(static_cast<NineBits>('b')) == 1);
+    REQUIRE(codes.Length(static_cast<NineBits>('c')) == 0);
+    // content that changed since counting must not be written without its bytes
+    REQUIRE_THROWS(codes.At(static_cast<NineBits>('c')));
+}
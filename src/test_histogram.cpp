@@ -0,0 +1,62 @@
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "histogram.h"
+#include "symbols_counter.h"
+
+static SymbolsCounter NaiveCount(const std::vector<char> &data, size_t offset) {
+    SymbolsCounter counter;
+    for (size_t i = offset; i < data.size(); ++i) {
+        ++counter[CharToNineBits(data[i])];
+    }
+    return counter;
+}
+
+TEST_CASE("Histogram_MatchesNaive") {
+    std::mt19937 gen(5);
+    for (size_t size : {0, 1, 15, 16, 31, 33, 1000, 100003}) {
+        std::vector<char> data(size);
+        for (auto &c : data) {
+            c = static_cast<char>(gen() % 5 == 0 ? gen() : 'a');
+        }
+        for (size_t offset : {0, 1, 7}) {
+            if (offset > size) {
+                continue;
+            }
+            auto expected = NaiveCount(data, offset);
+            SymbolsCounter counter;
+            CountBytes(data.data() + offset, data.data() + data.size(), counter);
+            REQUIRE(counter.GetUnder() == expected.GetUnder());
+        }
+    }
+}
+
+TEST_CASE("Histogram_Accumulates") {
+    std::vector<char> data(100, 'x');
+    SymbolsCounter counter;
+    ++counter[CharToNineBits('x')];
+    ++counter[NineBits{300}];
+    CountBytes(data.data(), data.data() + data.size(), counter);
+    REQUIRE(counter[CharToNineBits('x')] == 101);
+    REQUIRE(counter[NineBits{300}] == 1);
+}
+
+TEST_CASE("Histogram_Parallel") {
+    std::mt19937 gen(6);
+    std::vector<char> data(1000003);
+    for (auto &c : data) {
+        c = static_cast<char>(gen() % 7);
+    }
+    SymbolsCounter expected;
+    CountBytes(data.data(), data.data() + data.size(), expected);
+    for (size_t threads : {1, 2, 3, 8}) {
+        ThreadPool pool(threads);
+        for (size_t min_part : {1, 1000, 1 << 20}) {
+            SymbolsCounter counter;
+            ParallelCountBytes(data.data(), data.data() + data.size(), counter, pool, min_part);
+            REQUIRE(counter.GetUnder() == expected.GetUnder());
+        }
+    }
+}
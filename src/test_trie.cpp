@@ -0,0 +1,62 @@
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <catch.hpp>
+
+#include "trie.h"
+
+using Ways = std::vector<std::pair<std::vector<size_t>, int>>;
+
+TEST_CASE("FlatTrie_MatchesTrieNode") {
+    std::mt19937 gen(3);
+    TrieNode<int, 3> trie(false);
+    FlatTrie<int, 3, uint16_t> flat_trie;
+    for (int value = 0; value < 200; ++value) {
+        std::vector<size_t> way(gen() % 8);
+        for (auto &key : way) {
+            key = gen() % 3;
+        }
+        trie.AddWay(way.begin(), way.end(), value);
+        flat_trie.AddWay(way.begin(), way.end(), value);
+    }
+    Ways expected;
+    trie.WalkTrie([&](const auto &way, int value) { expected.emplace_back(way, value); });
+    Ways walked;
+    flat_trie.WalkTrie([&](const auto &way, int value) { walked.emplace_back(way, value); });
+    REQUIRE(walked == expected);
+
+    for (const auto &[way, value] : expected) {
+        const TrieNode<int, 3> *node = &trie;
+        auto flat_node = flat_trie.Root();
+        for (size_t key : way) {
+            node = node->GetChild(key);
+            flat_node = flat_trie.GetChild(flat_node, key);
+        }
+        REQUIRE(flat_trie.IsTerminal(flat_node));
+        REQUIRE(flat_trie.Value(flat_node) == node->Value());
+    }
+}
+
+TEST_CASE("FlatTrie_BuildBottomUp") {
+    FlatTrie<char, 2> trie;
+    auto a = trie.AddNode(true, 'a');
+    auto b = trie.AddNode(true, 'b');
+    auto c = trie.AddNode(true, 'c');
+    auto bc = trie.AddNode(false);
+    trie.SetChildren(bc, 0, b);
+    trie.SetChildren(bc, 1, c);
+    trie.SetChildren(trie.Root(), 0, a);
+    trie.SetChildren(trie.Root(), 1, bc);
+    REQUIRE(trie.GetChild(a, 0) == decltype(trie)::NO_NODE);
+
+    std::vector<std::pair<std::vector<size_t>, char>> walked;
+    trie.WalkTrie([&](const auto &way, char value) { walked.emplace_back(way, value); });
+    std::vector<std::pair<std::vector<size_t>, char>> expected = {{{0}, 'a'}, {{1, 0}, 'b'}, {{1, 1}, 'c'}};
+    REQUIRE(walked == expected);
+
+    walked.clear();
+    trie.WalkTrie(bc, [&](const auto &way, char value) { walked.emplace_back(way, value); });
+    REQUIRE(walked.size() == 2);
+    REQUIRE(walked[0].first.size() == 1);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Fixed set of worker threads executing submitted tasks in order of submission
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads) {
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { Work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopped_ = true;
+        }
+        has_tasks_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @return future with result of `func()` or exception thrown by it
+     */
+    template <typename F>
+    auto Submit(F func) -> std::future<decltype(func())> {
+        auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+        auto result = task->get_future();
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.emplace([task] { (*task)(); });
+        }
+        has_tasks_.notify_one();
+        return result;
+    }
+
+    size_t Size() const {
+        return workers_.size();
+    }
+
+private:
+    void Work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                has_tasks_.wait(lock, [this] { return stopped_ || !tasks_.empty(); });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_tasks_;
+    bool stopped_ = false;
+};
+
+/**
+ * @return results of `task(i)` for i in [0; count), computed by threads of `pool` or in place if it is null
+ *
+ * All tasks are finished before an exception thrown by some of them is rethrown, so they may reference locals.
+ */
+template <typename F>
+auto RunAll(ThreadPool *pool, size_t count, F task) -> std::vector<decltype(task(size_t{}))> {
+    std::vector<decltype(task(size_t{}))> results;
+    results.reserve(count);
+    if (pool == nullptr) {
+        for (size_t i = 0; i < count; ++i) {
+            results.push_back(task(i));
+        }
+        return results;
+    }
+    std::vector<std::future<decltype(task(size_t{}))>> futures;
+    futures.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        futures.push_back(pool->Submit([&task, i] { return task(i); }));
+    }
+    for (auto &future : futures) {
+        future.wait();
+    }
+    for (auto &future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
@@ -4,6 +4,10 @@
 #include <functional>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 /**
@@ -93,3 +97,131 @@ private:
     ArrayT children_;
     bool is_terminal_;
 };
+
+/**
+ * @brief Trie with nodes stored in one contiguous vector and linked by indices instead of pointers
+ *
+ * Node is addressed by its index, root has index 0. Nodes are never removed.
+ *
+ * @tparam T: type stored in nodes
+ * @tparam AlphabetSize: Alphabet is numbers in [0; AlphabetSize)
+ * @tparam IndexT: unsigned integer type of node indices, limits number of nodes
+ */
+template <typename T, size_t AlphabetSize, typename IndexT = uint32_t>
+class FlatTrie {
+public:
+    using AlphabetT = size_t;
+    using NodeIndex = IndexT;
+
+    static constexpr NodeIndex NO_NODE = std::numeric_limits<NodeIndex>::max();
+
+    explicit FlatTrie(size_t expected_nodes = 1) {
+        nodes_.reserve(expected_nodes);
+        AddNode(false);
+    }
+
+    static constexpr NodeIndex Root() {
+        return 0;
+    }
+
+    /**
+     * @return index of a new node without children
+     */
+    NodeIndex AddNode(bool is_terminal, T value = T()) {
+        if (nodes_.size() == NO_NODE) {
+            throw std::length_error("Too many trie nodes");
+        }
+        nodes_.push_back({{}, std::move(value), is_terminal});
+        nodes_.back().children.fill(NO_NODE);
+        return static_cast<NodeIndex>(nodes_.size() - 1);
+    }
+
+    void SetChildren(NodeIndex node, AlphabetT key, NodeIndex child) {
+        nodes_[node].children.at(key) = child;
+    }
+
+    bool IsTerminal(NodeIndex node) const {
+        return nodes_[node].is_terminal;
+    }
+
+    /**
+     * @return index of child if it exists and NO_NODE otherwise
+     */
+    NodeIndex GetChild(NodeIndex node, AlphabetT key) const {
+        return nodes_[node].children.at(key);
+    }
+
+    T Value(NodeIndex node) const {
+        return nodes_[node].value;
+    }
+
+    size_t Size() const {
+        return nodes_.size();
+    }
+
+    /**
+     * @return bytes of heap memory held by nodes
+     */
+    size_t MemoryUsage() const {
+        return nodes_.capacity() * sizeof(Node);
+    }
+
+    /**
+     * @brief calls `on_terminal(way, value)` for every terminal node of subtree of `from` in lexicographic order
+     */
+    template <typename F>
+    void WalkTrie(NodeIndex from, F &&on_terminal) const {
+        std::vector<AlphabetT> way;
+        WalkTrie(from, way, on_terminal);
+    }
+
+    template <typename F>
+    void WalkTrie(F &&on_terminal) const {
+        WalkTrie(Root(), std::forward<F>(on_terminal));
+    }
+
+    /**
+     * @brief Creates way from root. Make at the end terminated node with `value`
+     *
+     * @tparam It forward iterator of AlphabetT
+     */
+    template <typename It>
+    void AddWay(It way_first, It way_last, T value) {
+        NodeIndex node = Root();
+        for (; way_first != way_last; ++way_first) {
+            NodeIndex child = GetChild(node, *way_first);
+            if (child == NO_NODE) {
+                child = AddNode(false);
+                SetChildren(node, *way_first, child);
+            }
+            node = child;
+        }
+        nodes_[node].is_terminal = true;
+        nodes_[node].value = std::move(value);
+    }
+
+private:
+    struct Node {
+        std::array<NodeIndex, AlphabetSize> children;
+        T value;
+        bool is_terminal;
+    };
+
+    template <typename F>
+    void WalkTrie(NodeIndex node, std::vector<AlphabetT> &way, F &on_terminal) const {
+        if (IsTerminal(node)) {
+            on_terminal(way, nodes_[node].value);
+        }
+        for (AlphabetT i = 0; i < AlphabetSize; ++i) {
+            NodeIndex child = nodes_[node].children[i];
+            if (child == NO_NODE) {
+                continue;
+            }
+            way.push_back(i);
+            WalkTrie(child, way, on_terminal);
+            way.pop_back();
+        }
+    }
+
+    std::vector<Node> nodes_;
+};
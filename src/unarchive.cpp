@@ -1,128 +1,589 @@
+#include <array>
 #include <cstddef>
-#include <exception>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <ios>
+#include <memory>
+#include <optional>
+#include <set>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include "adaptive_haffman.h"
 #include "bits_stream.h"
+#include "blocks.h"
+#include "byte_source.h"
+#include "codes_io.h"
+#include "context_tables.h"
 #include "nine_bits.h"
-#include "trie.h"
-#include "bits.h"
+#include "decode_table.h"
 #include "constants.h"
+#include "thread_pool.h"
+#include "unarchive.h"
 
-using HaffmanTrieNode = TrieNode<NineBits, 2>;
+static const size_t CONTENT_CHUNK_SIZE = 1 << 16;
 
-template <typename IntT, typename IStreamT>
-static IntT ReadNineBitsAs(BitsIStream<IStreamT> &stream) {
-    NineBits nine_bits{};
-    stream >> nine_bits;
-    return static_cast<IntT>(nine_bits);
+template <typename StreamT>
+static NineBits ReadEncodedSymbol(BitsIStream<StreamT> &archive_stream, const DecodeTable &codes_table) {
+    return codes_table.Decode(archive_stream);
 }
 
 template <typename StreamT>
-static HaffmanTrieNode ReadCode(BitsIStream<StreamT> &archive_stream) {
-    size_t symbols_count = ReadNineBitsAs<size_t>(archive_stream);
-    std::vector<NineBits> symbols(symbols_count);
-    for (NineBits &symbol : symbols) {
-        archive_stream >> symbol;
-    }
-
-    std::vector<std::pair<NineBits, Bits>> haffman_codes;
-    haffman_codes.reserve(symbols.size());
-    Bits current_code;
-    for (size_t code_size = 1; haffman_codes.size() != symbols_count; ++code_size) {
-        size_t symbols_with_size = ReadNineBitsAs<size_t>(archive_stream);
-        current_code <<= 1;
-        if (haffman_codes.size() + symbols_with_size > symbols_count) {
-            throw std::runtime_error("Bad archive");
+static std::string ReadFileName(BitsIStream<StreamT> &archive_stream, const DecodeTable &codes_table) {
+    std::string filename;
+    while (true) {
+        NineBits symbol = ReadEncodedSymbol(archive_stream, codes_table);
+        if (symbol == FILENAME_END) {
+            return filename;
+        } else if (static_cast<uint16_t>(symbol) >= 256) {
+            throw std::runtime_error("Enexpected control symbol");
+        } else {
+            filename.push_back(static_cast<char>(symbol));
         }
-        for (size_t i = 0; i < symbols_with_size; ++i) {
-            haffman_codes.emplace_back(symbols[haffman_codes.size()], current_code);
-            ++current_code;
+    }
+}
+
+/**
+ * @brief reads codes of a file of Haffman stream format, which may be marked as codes of the previous file
+ *
+ * @param previous_codes codes of the previous file, replaced by the read ones
+ * @return codes of the file
+ */
+template <typename StreamT>
+static const DecodeTable &ReadFileCodes(BitsIStream<StreamT> &archive_stream,
+                                        std::shared_ptr<const DecodeTable> &previous_codes) {
+    if (archive_stream.Peek(9) == PREVIOUS_CODES_MARK) {
+        archive_stream.Consume(9);
+        if (!previous_codes) {
+            throw std::runtime_error("Bad archive");
         }
+    } else {
+        previous_codes = std::make_shared<const DecodeTable>(ReadCode(archive_stream));
     }
-    HaffmanTrieNode codes_trie(false);
-    for (const auto &[symbol, code] : haffman_codes) {
-        std::vector<size_t> way;
-        way.reserve(code.Size());
-        for (Bit b : code) {
-            way.push_back(static_cast<size_t>(b));
+    return *previous_codes;
+}
+
+/**
+ * @brief passes decoded content to `write(data, size)` by chunks of up to CONTENT_CHUNK_SIZE bytes
+ *
+ * @return false if it is last file, true otherwise
+ */
+template <typename StreamT, typename WriteF>
+static bool DecodeContent(BitsIStream<StreamT> &archive_stream, const DecodeTable &codes_table, WriteF write) {
+    std::array<char, CONTENT_CHUNK_SIZE> chunk;
+    size_t chunk_size = 0;
+    while (true) {
+        if (chunk.size() - chunk_size < DecodeTable::MAX_MULTI_BYTES) {
+            write(chunk.data(), chunk_size);
+            chunk_size = 0;
+        }
+        // content ends with a control symbol, which stops decoding of several bytes at once
+        if (size_t count = codes_table.DecodeBytes(archive_stream, chunk.data() + chunk_size)) {
+            chunk_size += count;
+            continue;
         }
-        codes_trie.AddWay(way.begin(), way.end(), symbol);
+        NineBits symbol = ReadEncodedSymbol(archive_stream, codes_table);
+        if (static_cast<uint16_t>(symbol) >= 256) {
+            write(chunk.data(), chunk_size);
+            if (symbol == ONE_MORE_FILE) {
+                return true;
+            } else if (symbol == ARCHIVE_END) {
+                return false;
+            }
+            throw std::runtime_error("Enexpected control symbol");
+        }
+        chunk[chunk_size++] = static_cast<char>(symbol);
     }
-    return codes_trie;
 }
 
+/**
+ * @brief Names of members to extract
+ */
+class MemberSelection {
+public:
+    /**
+     * @param names all members are selected if it is empty
+     */
+    explicit MemberSelection(const std::vector<std::string> &names) : names_(names.begin(), names.end()) {
+    }
+
+    /**
+     * @brief whether member `name` is selected, remembers that it is found
+     */
+    bool Select(const std::string &name) {
+        if (names_.empty()) {
+            return true;
+        }
+        if (names_.contains(name)) {
+            found_.insert(name);
+            return true;
+        }
+        return false;
+    }
+
+    void CheckAllFound() const {
+        for (const auto &name : names_) {
+            if (!found_.contains(name)) {
+                throw std::runtime_error("No file " + name + " in archive");
+            }
+        }
+    }
+
+private:
+    std::set<std::string> names_;
+    std::set<std::string> found_;
+};
+
+/**
+ * @brief extracts the file if it is selected and decodes it to nowhere otherwise, as there is no way to skip it
+ *
+ * @param previous_codes codes of the previous file, replaced by codes of this one
+ * @return false if it is last file, true otherwise
+ */
 template <typename StreamT>
-static NineBits ReadEncodedSymbol(BitsIStream<StreamT> &archive_stream, const HaffmanTrieNode &root) {
-    const HaffmanTrieNode *now_node = &root;  // never owns object
-    while (now_node != nullptr && !now_node->IsTerminal()) {
-        Bit b;
-        archive_stream >> b;
-        now_node = now_node->GetChild(static_cast<size_t>(b));
+static bool UnarchiveFile(BitsIStream<StreamT> &archive_stream, MemberSelection &selection, UnarchiveSink &sink,
+                          std::shared_ptr<const DecodeTable> &previous_codes) {
+    const DecodeTable &codes_table = ReadFileCodes(archive_stream, previous_codes);
+    std::string filename = ReadFileName(archive_stream, codes_table);
+    if (!selection.Select(filename)) {
+        return DecodeContent(archive_stream, codes_table, [](const char *, size_t) {});
     }
-    if (now_node == nullptr) {
-        throw std::runtime_error("Not find symbol");
+    sink.BeginFile(filename);
+    bool one_more_file = DecodeContent(archive_stream, codes_table,
+                                       [&sink](const char *data, size_t size) { sink.Write(data, size); });
+    sink.EndFile();
+    return one_more_file;
+}
+
+template <typename SourceT>
+static void UnarchiveFrom(SourceT &source, MemberSelection &selection, UnarchiveSink &sink) {
+    BitsIStream archive_stream(source);
+    std::shared_ptr<const DecodeTable> previous_codes;
+    while (UnarchiveFile(archive_stream, selection, sink, previous_codes)) {
     }
-    return now_node->Value();
 }
 
-template <typename StreamT>
-static std::string ReadFileName(BitsIStream<StreamT> &archive_stream, const HaffmanTrieNode &codes_trie) {
-    std::string filename;
+/**
+ * @brief Haffman block read from archive, decoded later
+ */
+struct BlockJob {
+    BlockJob() : source({}), stream(source) {
+    }
+
+    std::vector<char> storage;
+    SpanByteSource source;
+    BitsIStream<SpanByteSource> stream;
+    BlockMethod method = BlockMethod::HAFFMAN;
+    // null for blocks without a single table
+    std::shared_ptr<const DecodeTable> table;
+    // codes of interleaved blocks
+    std::span<const char> streams;
+    // content of stored blocks
+    std::span<const char> stored;
+    size_t raw_size = 0;
+};
+
+/**
+ * @brief the last table of the archive, blocks of skipped members leave it undecoded until some block reuses it
+ */
+class PreviousTable {
+public:
+    /**
+     * @return the table, or null if there is none
+     */
+    std::shared_ptr<const DecodeTable> Get() {
+        if (!pending_.empty()) {
+            SpanByteSource source(pending_);
+            BitsIStream stream(source);
+            table_ = std::make_shared<const DecodeTable>(ReadCode(stream));
+            pending_ = {};
+        }
+        return table_;
+    }
+
+    void Set(std::shared_ptr<const DecodeTable> table) {
+        table_ = std::move(table);
+        pending_ = {};
+    }
+
+    /**
+     * @brief replaces the table by the one at the start of the next `payload_size` bytes of `reader`
+     */
+    template <typename SourceT>
+    void SetPending(ByteReader<SourceT> &reader, size_t payload_size) {
+        table_.reset();
+        pending_ = reader.Take(payload_size, storage_);
+    }
+
+private:
+    std::shared_ptr<const DecodeTable> table_;
+    std::vector<char> storage_;
+    // payload of the block with the table if it isn't decoded yet
+    std::span<const char> pending_;
+};
+
+/**
+ * @brief decodes blocks of a member up to its end, blocks of a batch are decoded in parallel by `pool` if it is not
+ * null
+ *
+ * @param previous_table table of the previous block, which may be of the previous member, replaced by the last table
+ * of this member
+ */
+template <typename SourceT>
+static void DecodeBlocks(ByteReader<SourceT> &reader, UnarchiveSink &sink, ThreadPool *pool,
+                         PreviousTable &previous_table) {
+    size_t batch_size = pool != nullptr ? 2 * pool->Size() : 1;
+    std::vector<std::unique_ptr<BlockJob>> batch;
+    bool member_end = false;
+    while (!member_end) {
+        batch.clear();
+        while (batch.size() < batch_size) {
+            BlockHeader header = ReadBlockHeader(reader);
+            if (header.method == BlockMethod::MEMBER_END) {
+                member_end = true;
+                break;
+            }
+            auto job = std::make_unique<BlockJob>();
+            auto payload = reader.Take(header.payload_size, job->storage);
+            job->source = SpanByteSource(payload);
+            job->raw_size = header.raw_size;
+            job->method = header.method;
+            bool interleaved = header.method == BlockMethod::INTERLEAVED_HAFFMAN ||
+                               header.method == BlockMethod::INTERLEAVED_HAFFMAN_PREVIOUS_TABLE;
+            if (header.method == BlockMethod::HAFFMAN || header.method == BlockMethod::INTERLEAVED_HAFFMAN) {
+                job->table = std::make_shared<const DecodeTable>(ReadCode(job->stream));
+                previous_table.Set(job->table);
+            } else if (header.method == BlockMethod::HAFFMAN_PREVIOUS_TABLE ||
+                       header.method == BlockMethod::INTERLEAVED_HAFFMAN_PREVIOUS_TABLE) {
+                job->table = previous_table.Get();
+                if (!job->table) {
+                    throw std::runtime_error("Bad archive");
+                }
+            } else if (header.method == BlockMethod::STORED) {
+                job->stored = payload;
+            } else if (header.method != BlockMethod::ADAPTIVE_HAFFMAN &&
+                       header.method != BlockMethod::HAFFMAN_ORDER1) {
+                throw std::runtime_error("Bad archive");
+            }
+            if (interleaved) {
+                // streams follow the table aligned to byte
+                size_t table_size = (job->stream.ReadBits() + 7) / 8;
+                if (table_size > payload.size()) {
+                    throw std::runtime_error("Bad archive");
+                }
+                job->streams = payload.subspan(table_size);
+            }
+            batch.push_back(std::move(job));
+        }
+
+        auto decoded = RunAll(pool, batch.size(), [&batch](size_t i) {
+            BlockJob &job = *batch[i];
+            std::vector<char> content;
+            // stored blocks are written as they are
+            if (job.method == BlockMethod::STORED) {
+                return content;
+            }
+            content.resize(job.raw_size);
+            if (job.method == BlockMethod::ADAPTIVE_HAFFMAN) {
+                DecodeAdaptiveBlock(job.stream, content.data(), content.size());
+            } else if (job.method == BlockMethod::HAFFMAN_ORDER1) {
+                DecodeContextBlock(job.stream, content.data(), content.size());
+            } else if (job.method == BlockMethod::INTERLEAVED_HAFFMAN ||
+                       job.method == BlockMethod::INTERLEAVED_HAFFMAN_PREVIOUS_TABLE) {
+                DecodeInterleavedBlock(job.streams, *job.table, content.data(), content.size());
+            } else {
+                DecodeBlock(job.stream, *job.table, content.data(), content.size());
+            }
+            return content;
+        });
+        for (size_t i = 0; i < batch.size(); ++i) {
+            std::span<const char> content = batch[i]->method == BlockMethod::STORED ? batch[i]->stored : decoded[i];
+            sink.Write(content.data(), content.size());
+        }
+    }
+}
+
+/**
+ * @brief sizes of member content
+ */
+struct ContentSizes {
+    uint64_t original_size = 0;
+    uint64_t archived_size = 0;
+};
+
+/**
+ * @brief skips blocks of a member up to its end without decoding
+ *
+ * @param previous_table if not null, receives the last table of the member, which the next member may reuse
+ */
+template <typename SourceT>
+static ContentSizes SkipBlocks(ByteReader<SourceT> &reader, PreviousTable *previous_table = nullptr) {
+    ContentSizes sizes;
     while (true) {
-        NineBits symbol = ReadEncodedSymbol(archive_stream, codes_trie);
-        if (symbol == FILENAME_END) {
-            return filename;
-        } else if (static_cast<uint16_t>(symbol) >= 256) {
-            throw std::runtime_error("Enexpected control symbol");
+        BlockHeader header = ReadBlockHeader(reader);
+        sizes.archived_size += BLOCK_HEADER_SIZE;
+        if (header.method == BlockMethod::MEMBER_END) {
+            return sizes;
+        }
+        if (previous_table != nullptr &&
+            (header.method == BlockMethod::HAFFMAN || header.method == BlockMethod::INTERLEAVED_HAFFMAN)) {
+            previous_table->SetPending(reader, header.payload_size);
         } else {
-            filename.push_back(static_cast<char>(symbol));
+            reader.Skip(header.payload_size);
         }
+        sizes.original_size += header.raw_size;
+        sizes.archived_size += header.payload_size;
     }
 }
 
 /**
- * @return false if it is last file, true otherwise
+ * @return false if archive ends there instead of a member
  */
-template <typename StreamT>
-static bool DecodeContent(BitsIStream<StreamT> &archive_stream, const HaffmanTrieNode &codes_trie,
-                          std::ostream &content_stream) {
-    while (true) {
-        NineBits symbol = ReadEncodedSymbol(archive_stream, codes_trie);
-        if (symbol == ONE_MORE_FILE) {
-            return true;
-        } else if (symbol == ARCHIVE_END) {
-            return false;
-        } else if (static_cast<uint16_t>(symbol) >= 256) {
-            throw std::runtime_error("Enexpected control symbol");
+template <typename SourceT>
+static bool ReadMemberTag(ByteReader<SourceT> &reader) {
+    auto tag = static_cast<MemberTag>(reader.ReadUint(1));
+    if (tag == MemberTag::ARCHIVE_END) {
+        return false;
+    }
+    if (tag != MemberTag::MEMBER) {
+        throw std::runtime_error("Bad archive");
+    }
+    return true;
+}
+
+/**
+ * @brief extracts member starting at `reader` position if it is selected or skips it otherwise
+ *
+ * @param previous_table the last table of the previous member, replaced by the last table of this one
+ * @return false if archive ends there instead of a member
+ */
+template <typename SourceT>
+static bool UnarchiveMember(ByteReader<SourceT> &reader, MemberSelection &selection, UnarchiveSink &sink,
+                            ThreadPool *pool, PreviousTable &previous_table) {
+    if (!ReadMemberTag(reader)) {
+        return false;
+    }
+    std::string filename = ReadMemberName(reader);
+    if (selection.Select(filename)) {
+        sink.BeginFile(filename);
+        DecodeBlocks(reader, sink, pool, previous_table);
+        sink.EndFile();
+    } else {
+        SkipBlocks(reader, &previous_table);
+    }
+    return true;
+}
+
+template <typename SourceT>
+static void CheckMagic(ByteReader<SourceT> &reader) {
+    std::array<char, ARCHIVE_MAGIC.size()> magic;
+    reader.Read(magic.data(), magic.size());
+    if (magic != ARCHIVE_MAGIC) {
+        throw std::runtime_error(magic[1] == 'H' && magic[2] == 'A' ? "Unsupported archive version" : "Bad archive");
+    }
+}
+
+template <typename SourceT>
+static void UnarchiveBlocksFrom(SourceT &source, MemberSelection &selection, UnarchiveSink &sink, ThreadPool *pool) {
+    ByteReader reader(source);
+    CheckMagic(reader);
+    PreviousTable previous_table;
+    while (UnarchiveMember(reader, selection, sink, pool, previous_table)) {
+    }
+}
+
+/**
+ * @brief extracts selected members of indexed archive, `member_source(entry)` gives source positioned at the member
+ */
+template <typename MemberSourceF>
+static void UnarchiveIndexed(const std::vector<IndexEntry> &index, MemberSelection &selection, UnarchiveSink &sink,
+                             ThreadPool *pool, MemberSourceF member_source) {
+    MemberSelection all_members({});
+    for (const auto &entry : index) {
+        if (selection.Select(entry.name)) {
+            auto source = member_source(entry);
+            ByteReader reader(source);
+            // members of indexed archives don't reuse tables of previous ones
+            PreviousTable previous_table;
+            if (!UnarchiveMember(reader, all_members, sink, pool, previous_table)) {
+                throw std::runtime_error("Bad archive index");
+            }
+        }
+    }
+}
+
+/**
+ * @brief ReadIndex for stream, which is rewound after it
+ *
+ * @return nullopt for streams that can't seek, like pipes, as well
+ */
+static std::optional<std::vector<IndexEntry>> ReadStreamIndex(std::istream &archive) {
+    if (archive.tellg() == -1) {
+        return std::nullopt;
+    }
+    auto index = ReadIndex(archive);
+    archive.seekg(0);
+    return index;
+}
+
+void Unarchive(std::filesystem::path archive_name, UnarchiveSink &sink, const UnarchiveOptions &options) {
+    MemberSelection selection(options.members);
+    std::unique_ptr<ThreadPool> pool;
+    if (options.threads > 1) {
+        pool = std::make_unique<ThreadPool>(options.threads);
+    }
+    if (options.use_mmap && MMapByteSource::CanMap(archive_name)) {
+        MMapByteSource source(archive_name);
+        auto data = source.Data();
+        if (data.empty() || data[0] != ARCHIVE_MAGIC[0]) {
+            UnarchiveFrom(source, selection, sink);
+        } else if (auto index = options.members.empty() ? std::nullopt : ReadIndex(data)) {
+            SpanByteSource magic_source(data);
+            ByteReader magic_reader(magic_source);
+            CheckMagic(magic_reader);
+            UnarchiveIndexed(*index, selection, sink, pool.get(), [data](const IndexEntry &entry) {
+                return SpanByteSource(data.subspan(entry.offset, entry.compressed_size));
+            });
         } else {
-            content_stream << static_cast<char>(symbol);
+            UnarchiveBlocksFrom(source, selection, sink, pool.get());
+        }
+    } else {
+        std::ifstream file_archive_stream(archive_name, std::ios::binary);
+        file_archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit | std::ios_base::eofbit);
+        if (file_archive_stream.rdbuf()->sgetc() != static_cast<uint8_t>(ARCHIVE_MAGIC[0])) {
+            UnarchiveFrom(file_archive_stream, selection, sink);
+        } else if (auto index = options.members.empty() ? std::nullopt : ReadStreamIndex(file_archive_stream)) {
+            StreamByteSource magic_source(file_archive_stream);
+            ByteReader magic_reader(magic_source);
+            CheckMagic(magic_reader);
+            UnarchiveIndexed(*index, selection, sink, pool.get(), [&file_archive_stream](const IndexEntry &entry) {
+                file_archive_stream.seekg(static_cast<std::streamoff>(entry.offset));
+                return StreamByteSource(file_archive_stream);
+            });
+        } else {
+            StreamByteSource source(file_archive_stream);
+            UnarchiveBlocksFrom(source, selection, sink, pool.get());
         }
     }
+    selection.CheckAllFound();
 }
 
 /**
- * @return true if it is last file, false otherwise
+ * @brief Writes every file to the current directory, removing the file being written if extraction fails
  */
-template <typename StreamT>
-static bool UnarchiveFile(BitsIStream<StreamT> &archive_stream) {
-    auto codes_trie = ReadCode(archive_stream);
-    std::string filename = ReadFileName(archive_stream, codes_trie);
-    std::ofstream file_stream(filename);
-    file_stream.exceptions(std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
-    try {
-        return DecodeContent(archive_stream, codes_trie, file_stream);
-    } catch (...) {
-        std::filesystem::remove(filename);
-        std::rethrow_exception(std::current_exception());
+class FilesSink : public UnarchiveSink {
+public:
+    ~FilesSink() override {
+        if (file_stream_.is_open()) {
+            file_stream_.exceptions(std::ios_base::goodbit);
+            file_stream_.close();
+            std::filesystem::remove(filename_);
+        }
+    }
+
+    void BeginFile(const std::string &name) override {
+        filename_ = name;
+        file_stream_.exceptions(std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
+        file_stream_.open(filename_, std::ios::binary);
+    }
+
+    void Write(const char *data, size_t size) override {
+        file_stream_.write(data, static_cast<std::streamsize>(size));
+    }
+
+    void EndFile() override {
+        file_stream_.close();
+    }
+
+private:
+    std::string filename_;
+    std::ofstream file_stream_;
+};
+
+void Unarchive(std::filesystem::path archive_name, const UnarchiveOptions &options) {
+    FilesSink sink;
+    Unarchive(archive_name, sink, options);
+}
+
+/**
+ * @brief lists stream format archive, which has to be decoded for that as its files are not delimited otherwise
+ */
+template <typename SourceT>
+static std::vector<ArchiveMember> ListFrom(SourceT &source) {
+    BitsIStream archive_stream(source);
+    std::vector<ArchiveMember> members;
+    std::shared_ptr<const DecodeTable> previous_codes;
+    bool one_more_file = true;
+    while (one_more_file) {
+        size_t first_bit = archive_stream.ReadBits();
+        const DecodeTable &codes_table = ReadFileCodes(archive_stream, previous_codes);
+        ArchiveMember member{ReadFileName(archive_stream, codes_table), 0, 0};
+        one_more_file = DecodeContent(archive_stream, codes_table,
+                                      [&member](const char *, size_t size) { member.original_size += size; });
+        member.archived_size = (archive_stream.ReadBits() - first_bit + 7) / 8;
+        members.push_back(std::move(member));
+    }
+    return members;
+}
+
+/**
+ * @brief lists block format archive skipping over blocks
+ */
+template <typename SourceT>
+static std::vector<ArchiveMember> ListBlocksFrom(SourceT &source) {
+    ByteReader reader(source);
+    CheckMagic(reader);
+    std::vector<ArchiveMember> members;
+    while (ReadMemberTag(reader)) {
+        std::string name = ReadMemberName(reader);
+        auto sizes = SkipBlocks(reader);
+        uint64_t name_size = 1 + 2 + name.size();
+        members.push_back({std::move(name), sizes.original_size, name_size + sizes.archived_size});
     }
+    return members;
 }
 
-void Unarchive(std::filesystem::path archive_name) {
-    std::ifstream file_archive_stream(archive_name);
-    file_archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit | std::ios_base::eofbit);
-    BitsIStream archive_stream(file_archive_stream);
-    while (UnarchiveFile(archive_stream)) {
+static std::vector<ArchiveMember> ListIndexed(const std::vector<IndexEntry> &index) {
+    std::vector<ArchiveMember> members;
+    members.reserve(index.size());
+    for (const auto &entry : index) {
+        members.push_back({entry.name, entry.original_size, entry.compressed_size});
+    }
+    return members;
+}
+
+std::vector<ArchiveMember> ListArchive(std::filesystem::path archive_name, const UnarchiveOptions &options) {
+    if (options.use_mmap && MMapByteSource::CanMap(archive_name)) {
+        MMapByteSource source(archive_name);
+        auto data = source.Data();
+        if (data.empty() || data[0] != ARCHIVE_MAGIC[0]) {
+            return ListFrom(source);
+        }
+        if (auto index = ReadIndex(data)) {
+            SpanByteSource magic_source(data);
+            ByteReader magic_reader(magic_source);
+            CheckMagic(magic_reader);
+            return ListIndexed(*index);
+        }
+        return ListBlocksFrom(source);
+    }
+    std::ifstream file_archive_stream(archive_name, std::ios::binary);
+    return ListArchive(file_archive_stream);
+}
+
+std::vector<ArchiveMember> ListArchive(std::istream &archive_stream) {
+    archive_stream.exceptions(std::ios_base::failbit | std::ios_base::badbit | std::ios_base::eofbit);
+    if (archive_stream.rdbuf()->sgetc() != static_cast<uint8_t>(ARCHIVE_MAGIC[0])) {
+        return ListFrom(archive_stream);
+    }
+    auto index = ReadStreamIndex(archive_stream);
+    StreamByteSource source(archive_stream);
+    if (index) {
+        ByteReader magic_reader(source);
+        CheckMagic(magic_reader);
+        return ListIndexed(*index);
     }
+    return ListBlocksFrom(source);
 }
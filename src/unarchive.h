@@ -1,3 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct UnarchiveOptions {
+    /**
+     * @brief map archive into memory instead of reading it through stream
+     */
+    bool use_mmap = true;
+
+    /**
+     * @brief number of threads decoding blocks of block format archives
+     */
+    size_t threads = 1;
+
+    /**
+     * @brief names of files to extract, all files if it is empty; block format archives with index are not read
+     * besides these files
+     */
+    std::vector<std::string> members;
+};
+
+/**
+ * @brief Receiver of extracted files
+ */
+class UnarchiveSink {
+public:
+    virtual ~UnarchiveSink() = default;
+
+    /**
+     * @brief called before content of every extracted file
+     */
+    virtual void BeginFile(const std::string &name) = 0;
+
+    /**
+     * @brief called with content of the current file by chunks
+     */
+    virtual void Write(const char *data, size_t size) = 0;
+
+    /**
+     * @brief called after the whole content of the current file, not called if extraction fails
+     */
+    virtual void EndFile() = 0;
+};
+
+/**
+ * @brief Writes contents of all files one after another to a stream
+ */
+class StreamUnarchiveSink : public UnarchiveSink {
+public:
+    explicit StreamUnarchiveSink(std::ostream &stream) : stream_(stream) {
+    }
+
+    void BeginFile(const std::string &) override {
+    }
+
+    void Write(const char *data, size_t size) override {
+        stream_.write(data, static_cast<std::streamsize>(size));
+        CheckStream();
+    }
+
+    /**
+     * @brief flushes the stream, so bytes that fail to be written are reported with the file
+     */
+    void EndFile() override {
+        stream_.flush();
+        CheckStream();
+    }
+
+private:
+    void CheckStream() const {
+        if (!stream_) {
+            throw std::runtime_error("Can't write extracted file");
+        }
+    }
+
+    std::ostream &stream_;
+};
+
+/**
+ * @brief extracts files to the current directory
+ */
+void Unarchive(std::filesystem::path archive_name, const UnarchiveOptions &options = {});
+
+/**
+ * @brief passes extracted files to `sink` in order of archive
+ */
+void Unarchive(std::filesystem::path archive_name, UnarchiveSink &sink, const UnarchiveOptions &options = {});
+
+/**
+ * @brief File stored in archive
+ */
+struct ArchiveMember {
+    std::string name;
+    uint64_t original_size;
+
+    /**
+     * @brief bytes taken by the file in archive, rounded up for stream format archives whose files are not aligned
+     */
+    uint64_t archived_size;
+};
+
+/**
+ * @brief lists files of archive without extracting them; stream format archives are decoded for that, block format
+ * ones are read through index if it is present and skipped over by blocks otherwise
+ */
+std::vector<ArchiveMember> ListArchive(std::filesystem::path archive_name, const UnarchiveOptions &options = {});
 
-void Unarchive(std::filesystem::path archive_name);
+/**
+ * @brief ListArchive for archive read from `archive_stream`, which is read through if it can't seek and throws on
+ * errors after it
+ */
+std::vector<ArchiveMember> ListArchive(std::istream &archive_stream);